@@ -0,0 +1,153 @@
+/**
+* Throughput benchmark of the deployment control loop, without the arm.
+*
+* Runs the first root of a dot graph towards random goals, as
+* mainGrabStandalone.cpp would on the real WidowX: each step is a decision of
+* the TPG::TPGExecutionEngine, then a setPosition() and a waitFeedback() of
+* an armlearn::communication::SerialController. The controller talks to an
+* ArbotixEmulator on a pseudo-terminal, with the given link timing, instead of
+* /dev/ttyUSB0. The same steps are first run on the simulator used for
+* training, for reference, and last with a PipelinedControlLoop, which decides
+* the next action while the arm moves.
+*
+* Usage: deploymentLoop policy.dot [nbSteps] [latency (us)] [jitter (us)] [baudrate]
+*/
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <gegelati.h>
+
+#include "../src/ArbotixEmulator.h"
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/PipelinedControlLoop.h"
+
+/// Durations, in seconds, of the steps of a loop
+struct LoopTimes {
+    double inference = 0.0;
+    double actuation = 0.0;
+};
+
+/// Runs nbSteps decisions and actions, resetting the arm towards a new goal every episodeLength steps
+static LoopTimes runLoop(const TPG::TPGVertex &root, TPG::TPGExecutionEngine &tee, ArmLearnWrapper &le,
+                         uint64_t nbSteps, uint64_t episodeLength) {
+    LoopTimes times;
+    le.setRandomSeed(0);
+    for (uint64_t step = 0; step < nbSteps; step++) {
+        if (step % episodeLength == 0) {
+            delete le.targets.front();
+            le.customGoal(le.randomGoal());
+            le.reset();
+        }
+        auto start = std::chrono::steady_clock::now();
+        uint64_t action = ((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID();
+        auto decided = std::chrono::steady_clock::now();
+        le.doAction(action);
+        auto done = std::chrono::steady_clock::now();
+        times.inference += std::chrono::duration<double>(decided - start).count();
+        times.actuation += std::chrono::duration<double>(done - decided).count();
+    }
+    return times;
+}
+
+/// Runs the same steps as runLoop() with a PipelinedControlLoop, returns their duration in seconds
+static double runPipelinedLoop(const TPG::TPGVertex &root, PipelinedControlLoop &loop, ArmLearnWrapper &le,
+                               uint64_t nbSteps, uint64_t episodeLength) {
+    double duration = 0.0;
+    le.setRandomSeed(0);
+    for (uint64_t step = 0; step < nbSteps; step += episodeLength) {
+        delete le.targets.front();
+        le.customGoal(le.randomGoal());
+        le.reset();
+        auto start = std::chrono::steady_clock::now();
+        loop.run(root, std::min(episodeLength, nbSteps - step));
+        duration += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return duration;
+}
+
+static void printTimes(const char *controller, const LoopTimes &times, uint64_t nbSteps) {
+    printf("%s\t%.1lf\t%.1lf\t%.1lf\t%.1lf\n", controller, (double) nbSteps / (times.inference + times.actuation),
+           times.inference * 1e6 / (double) nbSteps, times.actuation * 1e6 / (double) nbSteps,
+           100.0 * times.inference / (times.inference + times.actuation));
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " policy.dot [nbSteps] [latency (us)] [jitter (us)] [baudrate]"
+                  << std::endl;
+        return 1;
+    }
+    uint64_t nbSteps = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 200;
+    ArbotixTiming timing;
+    timing.latency = (argc > 3) ? std::atof(argv[3]) : timing.latency;
+    timing.jitter = (argc > 4) ? std::atof(argv[4]) : timing.jitter;
+    timing.baudrate = (argc > 5) ? std::strtoul(argv[5], nullptr, 10) : timing.baudrate;
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson("../../params.json", params);
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+    TPG::TPGGraph tpg(env);
+    File::TPGGraphDotImporter dotImporter(argv[1], env, tpg);
+    dotImporter.importGraph();
+    if (tpg.getNbRootVertices() == 0) {
+        std::cerr << "No root in " << argv[1] << std::endl;
+        return 1;
+    }
+    const TPG::TPGVertex &root = *tpg.getRootVertices().front();
+    TPG::TPGExecutionEngine tee(env);
+
+    printf("Controller\tSteps/s\tInference(us)\tActuation(us)\tInference(%%)\n");
+    printTimes("simulator", runLoop(root, tee, le, nbSteps, params.maxNbActionsPerEval), nbSteps);
+
+    ArbotixEmulator emulator(timing);
+    emulator.start();
+    {
+        armlearn::communication::SerialController arbotix(emulator.getPortName(), timing.baudrate,
+                                                          armlearn::communication::none);
+        armlearn::WidowXBuilder builder;
+        builder.buildController(arbotix);
+        arbotix.connect();
+        arbotix.changeSpeed(50);
+        arbotix.updateInfos();
+
+        le.setController(&arbotix);
+        uint64_t nbCommands = emulator.getNbCommands();
+        uint64_t nbBytes = emulator.getNbBytes();
+        printTimes("emulator", runLoop(root, tee, le, nbSteps, params.maxNbActionsPerEval), nbSteps);
+        double trafficCommands = (double) (emulator.getNbCommands() - nbCommands) / (double) nbSteps;
+        double trafficBytes = (double) (emulator.getNbBytes() - nbBytes) / (double) nbSteps;
+
+        // Decisions overlapped with the motion of the arm
+        PipelinedControlLoop loop(le, set, params.nbRegisters);
+        double duration = runPipelinedLoop(root, loop, le, nbSteps, params.maxNbActionsPerEval);
+        printf("pipelined\t%.1lf\t-\t-\t-\n", (double) nbSteps / duration);
+
+        printf("Serial traffic per step: %.1lf commands, %.1lf bytes\n", trafficCommands, trafficBytes);
+        printf("Speculative decisions: %" PRIu64 ", %" PRIu64 " sent to the arm\n", loop.getNbSpeculations(),
+               loop.getNbHits());
+        le.setController(nullptr);
+    }
+    emulator.stop();
+
+    delete le.targets.front();
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+* Scaling benchmark of ArmLearnWrapper clones.
+*
+* For 1 to N threads, each thread runs episodes of pseudo-random actions on
+* its own clone of the environment and copies each observation into its own
+* data handler, as the execution engines of the clones read them. The total
+* number of steps per second is reported.
+*
+* Three layouts are compared:
+* - packed: the baseline, clones are created back-to-back by the main thread
+*   and observations are written into Data::PrimitiveTypeArray buffers also
+*   allocated back-to-back, so neighbouring threads write the same lines.
+* - main: clones are created by the main thread, observations are written
+*   into InlineArray aligned on cache lines.
+* - worker: same as main, but each clone is created by the thread using it.
+*
+* Efficiency is the throughput per thread relative to one thread of the same
+* layout, and VsPacked the throughput relative to the packed layout with the
+* same number of threads. Without false sharing, the efficiency of main and
+* worker stays close to 1 up to the number of cores while packed drops.
+*
+* Usage: environmentScaling [maxNbThreads] [nbStepsPerThread]
+*/
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/ArmLearnWrapper.h"
+#include "../src/InlineArray.h"
+
+// Number of steps of an episode before reset
+#define EPISODE_LENGTH 1000
+
+/// Layouts of the clones and of the observations written by the threads
+enum class Layout {
+    packed, main, worker
+};
+
+static const char *layoutNames[] = {"packed", "main", "worker"};
+
+/// Observation of a thread, alone on its cache lines
+struct alignas(64) ObservationSlot {
+    InlineArray<ARM_OBSERVATION_SIZE> observation;
+};
+
+/// Runs nbSteps pseudo-random actions on the environment, writing each observation into the handler
+template<class Handler>
+static void runSteps(ArmLearnWrapper &le, Handler &observation, uint64_t nbSteps, uint64_t seed) {
+    uint64_t rnd = seed;
+    double values[ARM_OBSERVATION_SIZE];
+    le.reset(seed);
+    for (uint64_t step = 0; step < nbSteps; step++) {
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 7;
+        rnd ^= rnd << 17;
+        le.doAction(rnd % le.getNbActions());
+        le.copyObservation(values);
+        for (size_t i = 0; i < ARM_OBSERVATION_SIZE; i++) {
+            observation.setDataAt(typeid(double), i, values[i]);
+        }
+        if ((step + 1) % EPISODE_LENGTH == 0) {
+            le.reset(seed + step);
+        }
+    }
+}
+
+/// Returns the number of steps per second of nbThreads threads
+static double measure(const ArmLearnWrapper &le, size_t nbThreads, uint64_t nbSteps, Layout layout) {
+    std::vector<std::unique_ptr<ArmLearnWrapper>> clones(nbThreads);
+    std::vector<std::unique_ptr<Data::PrimitiveTypeArray<double>>> packedObservations(nbThreads);
+    std::vector<ObservationSlot> slots(nbThreads);
+    if (layout != Layout::worker) {
+        for (size_t t = 0; t < nbThreads; t++) {
+            clones[t].reset((ArmLearnWrapper *) le.clone());
+            if (layout == Layout::packed) {
+                packedObservations[t].reset(new Data::PrimitiveTypeArray<double>(ARM_OBSERVATION_SIZE));
+            }
+        }
+    }
+
+    std::atomic<size_t> nbReady(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nbThreads; t++) {
+        threads.emplace_back([&, t]() {
+            if (layout == Layout::worker) {
+                clones[t].reset((ArmLearnWrapper *) le.clone());
+            }
+            nbReady++;
+            while (!go) {
+                std::this_thread::yield();
+            }
+            if (layout == Layout::packed) {
+                runSteps(*clones[t], *packedObservations[t], nbSteps, t + 1);
+            } else {
+                runSteps(*clones[t], slots[t].observation, nbSteps, t + 1);
+            }
+        });
+    }
+
+    while (nbReady < nbThreads) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    go = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    return (double) (nbSteps * nbThreads) / std::chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, char **argv) {
+    size_t maxNbThreads = (argc > 1) ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    uint64_t nbSteps = (argc > 2) ? std::stoull(argv[2]) : 20000;
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    le.targets.clear();
+    for (int j = 0; j < 10; j++) {
+        le.targets.emplace_back(le.randomGoal());
+    }
+    le.setDeterministicEvaluation(true);
+
+    std::vector<size_t> threadCounts;
+    for (size_t nbThreads = 1; nbThreads < maxNbThreads; nbThreads *= 2) {
+        threadCounts.push_back(nbThreads);
+    }
+    threadCounts.push_back(maxNbThreads);
+
+    printf("Layout\tThreads\tSteps/s\tPerThread\tEfficiency\tVsPacked\n");
+    std::vector<double> packed(threadCounts.size());
+    for (Layout layout : {Layout::packed, Layout::main, Layout::worker}) {
+        double reference = 0;
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            size_t nbThreads = threadCounts[i];
+            double stepsPerSecond = measure(le, nbThreads, nbSteps, layout);
+            if (nbThreads == 1) {
+                reference = stepsPerSecond;
+            }
+            if (layout == Layout::packed) {
+                packed[i] = stepsPerSecond;
+            }
+            printf("%s\t%zu\t%.0lf\t%.0lf\t%1.2lf\t%1.2lf\n", layoutNames[(int) layout], nbThreads, stepsPerSecond,
+                   stepsPerSecond / nbThreads, stepsPerSecond / (nbThreads * reference), stepsPerSecond / packed[i]);
+        }
+    }
+
+    for (auto target : le.targets) {
+        delete target;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+* Latency benchmark of the decisions of a trained policy.
+*
+* The first root of a dot graph decides on a fixed stream of observations of
+* the ArmLearnWrapper, recorded by an ObservationProbe from pseudo-random
+* episodes. For each decision, the latency of
+* TPG::TPGExecutionEngine::executeFromRoot(), the number of vertices visited
+* and the number of programs executed are measured.
+*
+* Decisions are first measured with cold caches, the caches being evicted
+* before each decision, then with warm caches, over nbPasses passes on the
+* stream. The percentiles of the latency size the period of the control
+* loop.
+*
+* Usage: inferenceLatency policy.dot [nbObservations] [nbPasses]
+* The number of registers is read from ../../params.json.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/ObservationProbe.h"
+
+// Size of the buffer written to evict the caches, larger than any last level cache
+#define EVICTION_SIZE (64 << 20)
+
+/// Measures of a decision
+struct Decision {
+    double latency;
+    uint64_t nbVertices;
+    uint64_t nbPrograms;
+};
+
+/// Number of programs executed by a TPG::TPGExecutionEngine to follow the path
+static uint64_t countPrograms(const std::vector<const TPG::TPGVertex *> &path) {
+    // edges leading to a team already visited are not evaluated
+    uint64_t nbPrograms = 0;
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        for (const TPG::TPGEdge *edge : path[i]->getOutgoingEdges()) {
+            if (std::find(path.begin(), path.begin() + i + 1, edge->getDestination()) == path.begin() + i + 1) {
+                nbPrograms++;
+            }
+        }
+    }
+    return nbPrograms;
+}
+
+/// Prints the percentiles of the latency, and the mean and max of the vertices and programs
+static void printDecisions(const char *cache, std::vector<Decision> decisions) {
+    std::sort(decisions.begin(), decisions.end(),
+              [](const Decision &a, const Decision &b) { return a.latency < b.latency; });
+    auto percentile = [&decisions](double p) {
+        return decisions[std::min(decisions.size() - 1, (size_t) (p * (double) decisions.size()))].latency;
+    };
+
+    double nbVertices = 0.0;
+    double nbPrograms = 0.0;
+    uint64_t maxVertices = 0;
+    uint64_t maxPrograms = 0;
+    for (const Decision &decision : decisions) {
+        nbVertices += (double) decision.nbVertices;
+        nbPrograms += (double) decision.nbPrograms;
+        maxVertices = std::max(maxVertices, decision.nbVertices);
+        maxPrograms = std::max(maxPrograms, decision.nbPrograms);
+    }
+    printf("%s\t%.2lf\t%.2lf\t%.2lf\t%.2lf\t%.1lf/%" PRIu64 "\t%.1lf/%" PRIu64 "\n", cache, percentile(0.5),
+           percentile(0.9), percentile(0.99), decisions.back().latency, nbVertices / (double) decisions.size(),
+           maxVertices, nbPrograms / (double) decisions.size(), maxPrograms);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " policy.dot [nbObservations] [nbPasses]" << std::endl;
+        return 1;
+    }
+    uint64_t nbObservations = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    uint64_t nbPasses = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 10;
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson("../../params.json", params);
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    le.targets.clear();
+    for (int j = 0; j < 10; j++) {
+        le.targets.emplace_back(le.randomGoal());
+    }
+    le.setDeterministicEvaluation(true);
+    ObservationProbe probe(set, params.nbRegisters);
+    probe.record(le, nbObservations, 0);
+    if (probe.getNbObservations() == 0) {
+        std::cerr << "No observation to decide on." << std::endl;
+        return 1;
+    }
+
+    // Data handlers with the layout of the wrapper, filled with the observations
+    Data::PrimitiveTypeArray<double> cartesianDif(3);
+    Data::PrimitiveTypeArray<double> motorPos(6);
+    Environment env(set, {cartesianDif, motorPos}, params.nbRegisters);
+    TPG::TPGGraph tpg(env);
+    File::TPGGraphDotImporter dotImporter(argv[1], env, tpg);
+    dotImporter.importGraph();
+    if (tpg.getNbRootVertices() == 0) {
+        std::cerr << "No root in " << argv[1] << std::endl;
+        return 1;
+    }
+    const TPG::TPGVertex &root = *tpg.getRootVertices().front();
+    TPG::TPGExecutionEngine tee(env);
+
+    std::vector<char> eviction(EVICTION_SIZE);
+    auto decide = [&](size_t i, bool cold) {
+        const std::vector<double> &observation = probe.getObservation(i);
+        for (size_t j = 0; j < 3; j++) {
+            cartesianDif.setDataAt(typeid(double), j, observation[j]);
+        }
+        for (size_t j = 0; j < 6; j++) {
+            motorPos.setDataAt(typeid(double), j, observation[3 + j]);
+        }
+        if (cold) {
+            for (size_t j = 0; j < eviction.size(); j += 64) {
+                eviction[j]++;
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto path = tee.executeFromRoot(root);
+        auto stop = std::chrono::steady_clock::now();
+        return Decision{std::chrono::duration<double, std::micro>(stop - start).count(), path.size(),
+                        countPrograms(path)};
+    };
+
+    std::vector<Decision> cold;
+    for (size_t i = 0; i < probe.getNbObservations(); i++) {
+        cold.push_back(decide(i, true));
+    }
+    std::vector<Decision> warm;
+    for (uint64_t pass = 0; pass < nbPasses; pass++) {
+        for (size_t i = 0; i < probe.getNbObservations(); i++) {
+            warm.push_back(decide(i, false));
+        }
+    }
+
+    printf("Cache\tp50(us)\tp90(us)\tp99(us)\tmax(us)\tVertices(mean/max)\tPrograms(mean/max)\n");
+    printDecisions("cold", cold);
+    if (!warm.empty()) {
+        printDecisions("warm", warm);
+    }
+
+    for (auto target : le.targets) {
+        delete target;
+    }
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return 0;
+}
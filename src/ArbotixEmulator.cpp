@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ArbotixEmulator.h"
+
+// Dynamixel protocol 1.0 instructions, SYNC_READ being an extension of the Arbotix firmware
+#define DYNAMIXEL_PING 0x01
+#define DYNAMIXEL_READ_DATA 0x02
+#define DYNAMIXEL_WRITE_DATA 0x03
+#define DYNAMIXEL_REG_WRITE 0x04
+#define DYNAMIXEL_ACTION 0x05
+#define DYNAMIXEL_RESET 0x06
+#define DYNAMIXEL_SYNC_WRITE 0x83
+#define DYNAMIXEL_SYNC_READ 0x84
+
+// Identifiers of the Arbotix itself and of broadcast packets
+#define ARBOTIX_ID 253
+#define BROADCAST_ID 254
+
+// Addresses of the control table
+#define REG_MODEL 0
+#define REG_ID 3
+#define REG_STATUS_RETURN 16
+#define REG_GOAL_POSITION 30
+#define REG_MOVING_SPEED 32
+#define REG_PRESENT_POSITION 36
+#define REG_PRESENT_SPEED 38
+#define REG_PRESENT_VOLTAGE 42
+#define REG_PRESENT_TEMPERATURE 43
+#define REG_MOVING 46
+
+// Size of the control table of a servo
+#define SERVO_TABLE_SIZE 74
+
+ArbotixEmulator::ArbotixEmulator(const ArbotixTiming &timing) : timing(timing), rng(timing.seed) {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    char name[128];
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 || ptsname_r(master, name, sizeof(name)) != 0) {
+        if (master >= 0) {
+            close(master);
+        }
+        throw std::runtime_error("Could not open a pseudo-terminal.");
+    }
+    portName = name;
+
+    slave = open(name, O_RDWR | O_NOCTTY);
+    struct termios settings;
+    if (slave >= 0 && tcgetattr(slave, &settings) == 0) {
+        // No echo nor line editing of the binary packets
+        cfmakeraw(&settings);
+        tcsetattr(slave, TCSANOW, &settings);
+    }
+
+    // WidowX, see WidowXBuilder
+    const uint16_t models[6] = {DYNAMIXEL_MX28, DYNAMIXEL_MX64, DYNAMIXEL_MX64, DYNAMIXEL_MX28, DYNAMIXEL_AX12,
+                                DYNAMIXEL_AX12};
+    const uint16_t backhoe[6] = {2048, 2048, 2048, 2048, 512, 256};
+    for (uint8_t i = 0; i < 6; i++) {
+        addServo(i + 1, models[i], backhoe[i]);
+    }
+}
+
+ArbotixEmulator::~ArbotixEmulator() {
+    stop();
+    if (slave >= 0) {
+        close(slave);
+    }
+    close(master);
+}
+
+void ArbotixEmulator::addServo(uint8_t id, uint16_t model, uint16_t position) {
+    Servo servo;
+    if (model == DYNAMIXEL_AX12) {
+        servo.maxPosition = 1023;
+        servo.unitsPerRevolution = 1024.0 * 360.0 / 300.0;
+        servo.rpmPerSpeedUnit = 0.111;
+    }
+    position = std::min(position, servo.maxPosition);
+    servo.position = position;
+    servo.table[REG_MODEL] = model & 0xFF;
+    servo.table[REG_MODEL + 1] = model >> 8;
+    servo.table[REG_ID] = id;
+    servo.table[REG_STATUS_RETURN] = 2;
+    servo.table[REG_GOAL_POSITION] = position & 0xFF;
+    servo.table[REG_GOAL_POSITION + 1] = position >> 8;
+    servo.table[REG_PRESENT_POSITION] = position & 0xFF;
+    servo.table[REG_PRESENT_POSITION + 1] = position >> 8;
+    servo.table[REG_PRESENT_VOLTAGE] = 120;
+    servo.table[REG_PRESENT_TEMPERATURE] = 40;
+    servo.lastUpdate = Clock::now();
+    servos[id] = servo;
+}
+
+void ArbotixEmulator::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    lineFree = Clock::now();
+    thread = std::thread(&ArbotixEmulator::run, this);
+}
+
+void ArbotixEmulator::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+const std::string &ArbotixEmulator::getPortName() const {
+    return portName;
+}
+
+uint64_t ArbotixEmulator::getNbCommands() const {
+    return nbCommands;
+}
+
+uint64_t ArbotixEmulator::getNbBytes() const {
+    return nbBytes;
+}
+
+ArbotixEmulator::Clock::duration ArbotixEmulator::transferTime(size_t nbTransferred) const {
+    // 8 data bits, a start and a stop bit
+    return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(10.0 * (double) nbTransferred / (double) timing.baudrate));
+}
+
+void ArbotixEmulator::run() {
+    uint8_t buffer[256];
+    struct pollfd input = {master, POLLIN, 0};
+    while (running) {
+        // the timeout bounds the time to notice stop()
+        if (poll(&input, 1, 50) <= 0 || (input.revents & POLLIN) == 0) {
+            continue;
+        }
+        ssize_t nbRead = read(master, buffer, sizeof(buffer));
+        if (nbRead > 0) {
+            pending.insert(pending.end(), buffer, buffer + nbRead);
+            parse(Clock::now());
+        }
+    }
+}
+
+void ArbotixEmulator::parse(Clock::time_point received) {
+    size_t begin = 0;
+    while (true) {
+        // 0xFF 0xFF id length instruction params checksum, length counting the instruction to the checksum
+        while (begin + 1 < pending.size() && !(pending[begin] == 0xFF && pending[begin + 1] == 0xFF)) {
+            begin++;
+        }
+        if (begin + 4 > pending.size() || begin + 4 + pending[begin + 3] > pending.size()) {
+            break;
+        }
+        uint8_t id = pending[begin + 2];
+        uint8_t length = pending[begin + 3];
+        size_t size = 4 + length;
+        if (id == 0xFF || length < 2) {
+            // not a header, the next 0xFF may be
+            begin++;
+            continue;
+        }
+
+        uint8_t sum = 0;
+        for (size_t i = begin + 2; i < begin + size - 1; i++) {
+            sum += pending[i];
+        }
+        if ((uint8_t) ~sum != pending[begin + size - 1]) {
+            begin++;
+            continue;
+        }
+        nbCommands++;
+        nbBytes += size;
+
+        // The command is executed once fully transferred, after the previous reply
+        lineFree = std::max(received, lineFree) + transferTime(size);
+        std::vector<uint8_t> reply;
+        execute(id, pending[begin + 4], pending.data() + begin + 5, length - 2, reply);
+        if (!reply.empty()) {
+            double latency = std::max(0.0, std::normal_distribution<double>(timing.latency, timing.jitter)(rng));
+            lineFree += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(latency))
+                        + transferTime(reply.size());
+            std::this_thread::sleep_until(lineFree);
+            size_t nbWritten = 0;
+            while (nbWritten < reply.size()) {
+                ssize_t written = write(master, reply.data() + nbWritten, reply.size() - nbWritten);
+                if (written <= 0) {
+                    break;
+                }
+                nbWritten += written;
+            }
+            nbBytes += reply.size();
+        }
+        begin += size;
+    }
+    pending.erase(pending.begin(), pending.begin() + std::min(begin, pending.size()));
+}
+
+void ArbotixEmulator::move(Servo &servo, Clock::time_point now) {
+    double elapsed = std::max(0.0, std::chrono::duration<double>(now - servo.lastUpdate).count());
+    servo.lastUpdate = std::max(servo.lastUpdate, now);
+
+    uint16_t goal = servo.table[REG_GOAL_POSITION] | (servo.table[REG_GOAL_POSITION + 1] << 8);
+    uint16_t speed = (servo.table[REG_MOVING_SPEED] | (servo.table[REG_MOVING_SPEED + 1] << 8)) & 0x3FF;
+    // 0 is the maximum speed, without control
+    double unitsPerSecond = ((speed == 0) ? 1023 : speed) * servo.rpmPerSpeedUnit / 60.0 * servo.unitsPerRevolution;
+    double distance = (double) goal - servo.position;
+    double step = unitsPerSecond * elapsed;
+    servo.position = (std::fabs(distance) <= step) ? goal : servo.position + std::copysign(step, distance);
+
+    uint16_t present = (uint16_t) std::lround(servo.position);
+    bool moving = present != goal;
+    servo.table[REG_PRESENT_POSITION] = present & 0xFF;
+    servo.table[REG_PRESENT_POSITION + 1] = present >> 8;
+    uint16_t presentSpeed = moving ? speed : 0;
+    servo.table[REG_PRESENT_SPEED] = presentSpeed & 0xFF;
+    servo.table[REG_PRESENT_SPEED + 1] = presentSpeed >> 8;
+    servo.table[REG_MOVING] = moving ? 1 : 0;
+}
+
+void ArbotixEmulator::appendStatus(uint8_t id, const std::vector<uint8_t> &params, std::vector<uint8_t> &reply) {
+    // 0xFF 0xFF id length error params checksum
+    uint8_t length = params.size() + 2;
+    uint8_t sum = id + length;
+    reply.push_back(0xFF);
+    reply.push_back(0xFF);
+    reply.push_back(id);
+    reply.push_back(length);
+    reply.push_back(0);
+    for (uint8_t param : params) {
+        reply.push_back(param);
+        sum += param;
+    }
+    reply.push_back(~sum);
+}
+
+void ArbotixEmulator::execute(uint8_t id, uint8_t instruction, const uint8_t *params, size_t nbParams,
+                              std::vector<uint8_t> &reply) {
+    // time at which the command is fully received
+    Clock::time_point now = lineFree;
+
+    if (instruction == DYNAMIXEL_SYNC_WRITE && nbParams >= 2) {
+        // address, data length, then the id and data of each servo
+        uint8_t address = params[0];
+        size_t dataLength = params[1];
+        for (size_t i = 2; i + 1 + dataLength <= nbParams; i += 1 + dataLength) {
+            auto servo = servos.find(params[i]);
+            if (servo != servos.end() && address + dataLength <= SERVO_TABLE_SIZE) {
+                move(servo->second, now);
+                std::copy(params + i + 1, params + i + 1 + dataLength, servo->second.table + address);
+            }
+        }
+        return;
+    }
+
+    if (id == BROADCAST_ID) {
+        // executed by every servo, none of them answering
+        std::vector<uint8_t> ignored;
+        for (auto &servo : servos) {
+            execute(servo.first, instruction, params, nbParams, ignored);
+        }
+        return;
+    }
+
+    if (id == ARBOTIX_ID) {
+        std::vector<uint8_t> data;
+        if (instruction == DYNAMIXEL_READ_DATA && nbParams >= 2) {
+            data.assign(params[1], 0);
+        } else if (instruction == DYNAMIXEL_SYNC_READ && nbParams >= 2) {
+            // address, data length, then the ids of the servos, answered in a single packet
+            uint8_t address = params[0];
+            size_t dataLength = params[1];
+            for (size_t i = 2; i < nbParams; i++) {
+                auto servo = servos.find(params[i]);
+                for (size_t j = 0; j < dataLength; j++) {
+                    if (servo != servos.end() && address + j < SERVO_TABLE_SIZE) {
+                        move(servo->second, now);
+                        data.push_back(servo->second.table[address + j]);
+                    } else {
+                        data.push_back(0);
+                    }
+                }
+            }
+        }
+        appendStatus(id, data, reply);
+        return;
+    }
+
+    auto servo = servos.find(id);
+    if (servo == servos.end()) {
+        // nobody answers on the bus, the host times out
+        return;
+    }
+    Servo &target = servo->second;
+    move(target, now);
+
+    std::vector<uint8_t> data;
+    switch (instruction) {
+        case DYNAMIXEL_PING:
+            break;
+        case DYNAMIXEL_READ_DATA:
+            if (nbParams < 2 || params[0] + params[1] > SERVO_TABLE_SIZE) {
+                return;
+            }
+            data.assign(target.table + params[0], target.table + params[0] + params[1]);
+            break;
+        case DYNAMIXEL_WRITE_DATA:
+        case DYNAMIXEL_REG_WRITE:
+            if (nbParams < 1 || params[0] + nbParams - 1 > SERVO_TABLE_SIZE) {
+                return;
+            }
+            // Registered writes are applied at once, the emulated bus has no concurrent motion to synchronize
+            std::copy(params + 1, params + nbParams, target.table + params[0]);
+            if (params[0] <= REG_GOAL_POSITION + 1 && params[0] + nbParams - 1 > REG_GOAL_POSITION) {
+                uint16_t goal = target.table[REG_GOAL_POSITION] | (target.table[REG_GOAL_POSITION + 1] << 8);
+                goal = std::min(goal, target.maxPosition);
+                target.table[REG_GOAL_POSITION] = goal & 0xFF;
+                target.table[REG_GOAL_POSITION + 1] = goal >> 8;
+            }
+            break;
+        case DYNAMIXEL_ACTION:
+        case DYNAMIXEL_RESET:
+            break;
+        default:
+            return;
+    }
+
+    if (target.table[REG_STATUS_RETURN] == 2 ||
+        (target.table[REG_STATUS_RETURN] == 1 && instruction == DYNAMIXEL_READ_DATA)) {
+        appendStatus(id, data, reply);
+    }
+}
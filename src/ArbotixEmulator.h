@@ -0,0 +1,158 @@
+#ifndef ARMGEGELATI_ARBOTIXEMULATOR_H
+#define ARMGEGELATI_ARBOTIXEMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Dynamixel protocol 1.0 model numbers of the servos of the WidowX
+#define DYNAMIXEL_AX12 12
+#define DYNAMIXEL_MX28 29
+#define DYNAMIXEL_MX64 310
+
+/// Timing of the link between the host and the Arbotix, see ArbotixEmulator
+struct ArbotixTiming {
+    /// Serial speed, in bits per second, of 10-bit bytes
+    uint32_t baudrate = 115200;
+
+    /// Delay between the end of a command and the start of its reply, in microseconds
+    double latency = 1000.0;
+
+    /// Standard deviation of the latency, in microseconds
+    double jitter = 200.0;
+
+    /// Seed of the jitter
+    uint64_t seed = 0;
+};
+
+/**
+* \brief Stand-in for an Arbotix board and its servos, on a pseudo-terminal.
+*
+* The emulator answers the Dynamixel protocol 1.0 packets written on the
+* slave side of a pseudo-terminal, so that an unmodified
+* armlearn::communication::SerialController opened on getPortName() drives it
+* as it drives the real arm on /dev/ttyUSB0. Deployment loops can then be
+* benchmarked offline, serial traffic included.
+*
+* Commands and replies take their transfer time at the baudrate of the
+* ArbotixTiming, one after the other, and replies are delayed by the latency
+* and its jitter. Servos move towards their goal position at their moving
+* speed, so that waitFeedback() lasts as long as the motion of the arm.
+*/
+class ArbotixEmulator {
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    /// Control table of a servo, with its simulated motion
+    struct Servo {
+        uint8_t table[74] = {0};
+
+        /// Exact position, of which the present position register is the rounding
+        double position = 0.0;
+
+        /// Highest position
+        uint16_t maxPosition = 4095;
+
+        /// Number of position units per revolution
+        double unitsPerRevolution = 4096.0;
+
+        /// Revolutions per minute of a unit of the moving speed register
+        double rpmPerSpeedUnit = 0.114;
+
+        /// Last update of position
+        Clock::time_point lastUpdate;
+    };
+
+    ArbotixTiming timing;
+
+    std::map<uint8_t, Servo> servos;
+
+    /// Master side of the pseudo-terminal
+    int master = -1;
+
+    /// Slave side, kept open so that the master never reads a hang-up
+    int slave = -1;
+
+    std::string portName;
+
+    std::thread thread;
+
+    std::atomic<bool> running{false};
+
+    /// Bytes received and not yet parsed
+    std::vector<uint8_t> pending;
+
+    /// End of the transfer of the last reply, the link is busy until then
+    Clock::time_point lineFree;
+
+    std::mt19937_64 rng;
+
+    std::atomic<uint64_t> nbCommands{0};
+
+    std::atomic<uint64_t> nbBytes{0};
+
+    /// Reads and answers commands until stop()
+    void run();
+
+    /// Answers the complete packets of pending
+    void parse(Clock::time_point received);
+
+    /// Executes a packet, appending its status packets to reply
+    void execute(uint8_t id, uint8_t instruction, const uint8_t *params, size_t nbParams,
+                 std::vector<uint8_t> &reply);
+
+    /// Moves the servo towards its goal position, up to now
+    void move(Servo &servo, Clock::time_point now);
+
+    /// Appends a status packet to reply
+    static void appendStatus(uint8_t id, const std::vector<uint8_t> &params, std::vector<uint8_t> &reply);
+
+    /// Duration of the transfer of nbTransferred bytes
+    Clock::duration transferTime(size_t nbTransferred) const;
+
+public:
+    /**
+    * \brief Opens the pseudo-terminal, with the six servos of the WidowX in
+    * backhoe position.
+    *
+    * Throws std::runtime_error if no pseudo-terminal can be opened.
+    */
+    explicit ArbotixEmulator(const ArbotixTiming &timing = ArbotixTiming());
+
+    /// Stops the emulator and closes the pseudo-terminal
+    ~ArbotixEmulator();
+
+    ArbotixEmulator(const ArbotixEmulator &) = delete;
+
+    ArbotixEmulator &operator=(const ArbotixEmulator &) = delete;
+
+    /**
+    * \brief Adds or replaces a servo, before start().
+    *
+    * \param[in] model the model number, DYNAMIXEL_AX12 for servos with 1024
+    * positions on 300 degrees, any MX model for 4096 positions on 360 degrees.
+    */
+    void addServo(uint8_t id, uint16_t model, uint16_t position);
+
+    /// Starts answering commands on a thread
+    void start();
+
+    /// Stops the thread answering commands
+    void stop();
+
+    /// Path of the slave side, to give to armlearn::communication::SerialController
+    const std::string &getPortName() const;
+
+    /// Number of packets received
+    uint64_t getNbCommands() const;
+
+    /// Number of bytes received and sent
+    uint64_t getNbBytes() const;
+};
+
+#endif //ARMGEGELATI_ARBOTIXEMULATOR_H
@@ -0,0 +1,34 @@
+#include <cmath>
+
+#include "ArmInstructions.h"
+
+void fillArmInstructionSet(Instructions::Set &set, bool ternaryInstructions) {
+    auto minus = [](double a, double b) -> double { return a - b; };
+    auto add = [](double a, double b) -> double { return a + b; };
+    auto times = [](double a, double b) -> double { return a * b; };
+    auto divide = [](double a, double b) -> double { return a / b; };
+    auto cond = [](double a, double b) -> double { return a < b ? -a : a; };
+    auto cos = [](double a) -> double { return std::cos(a); };
+    auto sin = [](double a) -> double { return std::sin(a); };
+    // no overflow protection as in std::hypot, inputs are distances and positions of the arm
+    auto hypot3 = [](double a, double b, double c) -> double { return std::sqrt(a * a + b * b + c * c); };
+    auto atan2 = [](double a, double b) -> double { return std::atan2(a, b); };
+    auto clamp = [](double a, double b) -> double { return std::fmin(std::fmax(a, -std::fabs(b)), std::fabs(b)); };
+    auto servoToRadian = [](double a) -> double { return (a - SERVO_CENTER) * SERVO_TO_RADIAN; };
+    auto sign = [](double a) -> double { return (double) ((a > 0) - (a < 0)); };
+
+    set.add(*(new Instructions::LambdaInstruction<double, double>(minus)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(add)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(times)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(divide)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(cond)));
+    set.add(*(new Instructions::LambdaInstruction<double>(cos)));
+    set.add(*(new Instructions::LambdaInstruction<double>(sin)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(atan2)));
+    set.add(*(new Instructions::LambdaInstruction<double, double>(clamp)));
+    set.add(*(new Instructions::LambdaInstruction<double>(servoToRadian)));
+    set.add(*(new Instructions::LambdaInstruction<double>(sign)));
+    if (ternaryInstructions) {
+        set.add(*(new Instructions::LambdaInstruction<double, double, double>(hypot3)));
+    }
+}
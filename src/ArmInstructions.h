@@ -0,0 +1,52 @@
+#ifndef ARMGEGELATI_ARMINSTRUCTIONS_H
+#define ARMGEGELATI_ARMINSTRUCTIONS_H
+
+#include <gegelati.h>
+
+// Radians per position of the MX servos of the WidowX, 4096 positions per turn
+#define SERVO_TO_RADIAN 0.0015339807878856412
+// Position of an MX servo at 0 radian
+#define SERVO_CENTER 2048.0
+
+/**
+* \brief Index of each instruction in the set filled by fillArmInstructionSet().
+*
+* Programs, exported policies and generated code refer to instructions by
+* these indices, so new instructions must be added at the end.
+*/
+enum ArmInstruction : uint64_t {
+    ARM_MINUS = 0,
+    ARM_ADD,
+    ARM_TIMES,
+    ARM_DIVIDE,
+    /// -a if a < b, a otherwise
+    ARM_COND,
+    ARM_COS,
+    ARM_SIN,
+    /// Angle of the point (b, a), in ]-pi, pi]
+    ARM_ATAN2,
+    /// a clamped in [-|b|, |b|]
+    ARM_CLAMP,
+    /// Angle in radians of the servo position a, see SERVO_TO_RADIAN
+    ARM_SERVO_TO_RADIAN,
+    /// -1, 0 or 1 according to the sign of a, 0 for NaN
+    ARM_SIGN,
+    /// Norm of the vector (a, b, c), e.g. the distance to the goal from cartesianDif, only with ternaryInstructions
+    ARM_HYPOT3,
+    NB_ARM_INSTRUCTIONS
+};
+
+/**
+* \brief Adds the instructions of armGegelati to a set, in ArmInstruction order.
+*
+* Used by training, testing and every tool loading a graph, so that they
+* all interpret programs the same way. The instructions are allocated and
+* must be deleted by the caller.
+*
+* \param[in] ternaryInstructions adds ARM_HYPOT3, the only instruction with
+* 3 operands. It changes the number of operands of every program line, so
+* graphs trained without it can only be loaded without it, and conversely.
+*/
+void fillArmInstructionSet(Instructions::Set &set, bool ternaryInstructions = false);
+
+#endif //ARMGEGELATI_ARMINSTRUCTIONS_H
@@ -0,0 +1,66 @@
+#include <fstream>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+#include "ArmLearnParameters.h"
+#include "ThreadPlacement.h"
+
+bool loadArmLearnParametersFromJson(const char *path, ArmLearnParameters &params) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    auto cfg = nlohmann::json::parse(file, nullptr, false);
+    if (cfg.is_discarded()) {
+        std::cerr << "Could not parse " << path << std::endl;
+        return false;
+    }
+    if (!cfg.contains("wrapper")) {
+        return true;
+    }
+
+    const auto &wrapper = cfg["wrapper"];
+    params.deterministicEvaluation = wrapper.value("deterministicEvaluation", params.deterministicEvaluation);
+    params.intraRootParallelism = wrapper.value("intraRootParallelism", params.intraRootParallelism);
+    params.ternaryInstructions = wrapper.value("ternaryInstructions", params.ternaryInstructions);
+    params.scheduler = wrapper.value("scheduler", params.scheduler);
+    params.pinThreads = wrapper.value("pinThreads", params.pinThreads);
+    params.cpus = wrapper.value("cpus", params.cpus);
+    params.scatterThreads = wrapper.value("scatterThreads", params.scatterThreads);
+    params.nbIslands = wrapper.value("nbIslands", params.nbIslands);
+    params.migrationPeriod = wrapper.value("migrationPeriod", params.migrationPeriod);
+    params.racing = wrapper.value("racing", params.racing);
+    params.racingConfidence = wrapper.value("racingConfidence", params.racingConfidence);
+    params.deduplication = wrapper.value("deduplication", params.deduplication);
+    params.nbProbeObservations = wrapper.value("nbProbeObservations", params.nbProbeObservations);
+    params.cycleDetection = wrapper.value("cycleDetection", params.cycleDetection);
+    params.decisionMemoization = wrapper.value("decisionMemoization", params.decisionMemoization);
+    params.incrementalExecution = wrapper.value("incrementalExecution", params.incrementalExecution);
+    params.jit = wrapper.value("jit", params.jit);
+    params.jitMinAge = wrapper.value("jitMinAge", params.jitMinAge);
+    params.jitCompiler = wrapper.value("jitCompiler", params.jitCompiler);
+    params.jitDirectory = wrapper.value("jitDirectory", params.jitDirectory);
+    params.laneExecution = wrapper.value("laneExecution", params.laneExecution);
+    params.forkedEvaluation = wrapper.value("forkedEvaluation", params.forkedEvaluation);
+    params.shardAddress = wrapper.value("shardAddress", params.shardAddress);
+    params.nbLocalShardWorkers = wrapper.value("nbLocalShardWorkers", params.nbLocalShardWorkers);
+    params.nbShardWorkers = wrapper.value("nbShardWorkers", params.nbShardWorkers);
+    params.shardSize = wrapper.value("shardSize", params.shardSize);
+    params.shardTimeout = wrapper.value("shardTimeout", params.shardTimeout);
+    params.trajectoryFile = wrapper.value("trajectoryFile", params.trajectoryFile);
+    params.trajectoryCapacity = wrapper.value("trajectoryCapacity", params.trajectoryCapacity);
+    params.trajectoryRing = wrapper.value("trajectoryRing", params.trajectoryRing);
+
+    // cpu ids are used as indices of cpu_set_t
+    for (int cpu : params.cpus) {
+        if (!ThreadPlacement::isValidCpu(cpu)) {
+            std::cerr << "Invalid cpu " << cpu << " in " << path << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
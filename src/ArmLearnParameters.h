@@ -0,0 +1,114 @@
+#ifndef ARMGEGELATI_ARMLEARNPARAMETERS_H
+#define ARMGEGELATI_ARMLEARNPARAMETERS_H
+
+#include <string>
+#include <vector>
+
+/**
+* \brief Parameters of the armlearn-wrapper, read from the "wrapper" section of params.json.
+*
+* Learn::LearningParameters of gegelati are read from the same file by
+* File::ParametersParser::loadParametersFromJson().
+*/
+struct ArmLearnParameters {
+    /// Evaluates roots with a single pass over the goals, see ArmLearnWrapper::setDeterministicEvaluation()
+    bool deterministicEvaluation = false;
+
+    /// Dispatches the episodes of a root on several threads, see ArmLearningAgent::setIntraRootParallelism()
+    bool intraRootParallelism = false;
+
+    /// Adds the 3-operand ARM_HYPOT3 to the instruction set, see fillArmInstructionSet()
+    bool ternaryInstructions = false;
+
+    /// Distribution of evaluation jobs on threads: "parallelLoop" or "workStealing"
+    std::string scheduler = "parallelLoop";
+
+    /// Pins evaluation threads on cpus, see ThreadPlacement
+    bool pinThreads = false;
+
+    /// Cpus used by pinned threads, all available cpus if empty
+    std::vector<int> cpus;
+
+    /// Spreads consecutive threads over NUMA nodes instead of filling nodes one by one
+    bool scatterThreads = false;
+
+    /// Number of populations trained in parallel, see IslandModel
+    uint64_t nbIslands = 1;
+
+    /// Number of generations between two migrations of the best roots of islands
+    uint64_t migrationPeriod = 10;
+
+    /// Stops the evaluation of roots that can not survive the decimation, see ArmLearningAgent::setRacing()
+    bool racing = false;
+
+    /// 1 to only stop roots that can not survive, or probability for a stopped root not to survive
+    double racingConfidence = 1.0;
+
+    /// Evaluates once behaviourally identical new roots, see ArmLearningAgent::setDeduplication()
+    bool deduplication = false;
+
+    /// Number of recorded observations on which roots are compared
+    uint64_t nbProbeObservations = 64;
+
+    /// Ends episodes once the arm cycles, see ArmLearnWrapper::setEpisodeLength()
+    bool cycleDetection = false;
+
+    /// Remembers the decisions of evaluated roots, see ArmLearningAgent::setDecisionMemoization()
+    bool decisionMemoization = false;
+
+    /// Only re-executes programs whose inputs changed, see ArmLearningAgent::setIncrementalExecution()
+    bool incrementalExecution = false;
+
+    /// Compiles long-lived programs to native code, see ArmLearningAgent::setJit()
+    bool jit = false;
+
+    /// Number of generations a program must survive before being compiled
+    uint64_t jitMinAge = 10;
+
+    /// C compiler used by the JIT
+    std::string jitCompiler = "cc";
+
+    /// Directory of the temporary files of the JIT
+    std::string jitDirectory = "/tmp";
+
+    /// Runs the episodes of a root on several arms at once, see ArmLearningAgent::setLaneExecution()
+    bool laneExecution = false;
+
+    /// Evaluates roots in forked processes instead of threads, see ForkedEvaluator
+    bool forkedEvaluation = false;
+
+    /// Address on which evaluation workers connect, "tcp:host:port" or "unix:path", empty to evaluate locally
+    std::string shardAddress;
+
+    /// Number of evaluation workers started on this machine, see ShardedEvaluator::spawnLocalWorkers()
+    uint64_t nbLocalShardWorkers = 0;
+
+    /// Number of remote evaluation workers waited for before training
+    uint64_t nbShardWorkers = 0;
+
+    /// Number of roots sent to an evaluation worker at once
+    uint64_t shardSize = 16;
+
+    /// Seconds after which an evaluation worker that did not return its shard is dropped
+    uint64_t shardTimeout = 600;
+
+    /// File recording the steps of all episodes, see TrajectoryRecorder, empty to record nothing
+    std::string trajectoryFile;
+
+    /// Maximum number of steps in the trajectory file
+    uint64_t trajectoryCapacity = 1000000;
+
+    /// Overwrites the oldest steps once the trajectory file is full, instead of dropping new ones
+    bool trajectoryRing = true;
+};
+
+/**
+* \brief Loads the "wrapper" section of a json file in the given parameters.
+*
+* Parameters missing from the file keep their current value.
+* \return false if the file could not be read, or if it holds invalid
+* values, such as cpu ids that can not be pinned.
+*/
+bool loadArmLearnParametersFromJson(const char *path, ArmLearnParameters &params);
+
+#endif //ARMGEGELATI_ARMLEARNPARAMETERS_H
@@ -3,10 +3,14 @@
 void ArmLearnWrapper::computeInput() {
     auto deviceStates = DeviceLearner::getDeviceState();
     std::vector<uint16_t> newMotorPos;
+    state.inputVersion++;
     int indInput = 0;
     for (auto &deviceState : deviceStates) {
         for (unsigned short &value : deviceState) {
-            motorPos.setDataAt(typeid(double), indInput, value);
+            if (state.motorPos.getValues()[indInput] != value) {
+                state.inputChangeVersion[3 + indInput] = state.inputVersion;
+            }
+            state.motorPos.setDataAt(typeid(double), indInput, value);
             newMotorPos.emplace_back(value);
             indInput++;
         }
@@ -15,12 +19,21 @@ void ArmLearnWrapper::computeInput() {
     auto newCartesianCoords = converter->computeServoToCoord(newMotorPos)->getCoord();
 
     for (int i = 0; i < newCartesianCoords.size(); i++) {
-        cartesianPos.setDataAt(typeid(double), i, newCartesianCoords[i]);
-        cartesianDif.setDataAt(typeid(double), i, targets[0]->getInput()[i] - newCartesianCoords[i]);
+        if (state.cartesianPos.getValues()[i] != newCartesianCoords[i]) {
+            state.inputChangeVersion[i] = state.inputVersion;
+        }
+        state.cartesianPos.setDataAt(typeid(double), i, newCartesianCoords[i]);
+        state.cartesianDif.setDataAt(typeid(double), i, state.goal[i] - newCartesianCoords[i]);
     }
 }
 
 void ArmLearnWrapper::doAction(uint64_t actionID) {
+    startAction(actionID);
+    waitActionFeedback();
+    finishAction();
+}
+
+std::vector<uint16_t> ArmLearnWrapper::computeActionPosition(uint64_t actionID) const {
     std::vector<double> out;
     double step = M_PI / 180; // discrete rotations of some °
 
@@ -71,43 +84,109 @@ void ArmLearnWrapper::doAction(uint64_t actionID) {
 
     // changes relative coordinates to absolute
     for (int i = 0; i < 4; i++) {
-        double inputI = (double) *(motorPos.getDataAt(typeid(double), i).getSharedPointer<const double>());
-        scaledOutput[i] = (scaledOutput[i] - 2048) + inputI;
+        scaledOutput[i] = (scaledOutput[i] - 2048) + state.motorPos.getValues()[i];
     }
     scaledOutput[0] += 1;
-    double inputI = (double) *(motorPos.getDataAt(typeid(double), 4).getSharedPointer<const double>());
-    scaledOutput[4] = (scaledOutput[4] - 511) + inputI;
-    inputI = (double) *(motorPos.getDataAt(typeid(double), 5).getSharedPointer<const double>());
-    scaledOutput[5] = (scaledOutput[5] - 256) + inputI;
+    scaledOutput[4] = (scaledOutput[4] - 511) + state.motorPos.getValues()[4];
+    scaledOutput[5] = (scaledOutput[5] - 256) + state.motorPos.getValues()[5];
     // TODO 8-2 et 3-9 ne donne pas la même chose alors que ça devrait
 
 
-    auto validOutput = device->toValidPosition(scaledOutput);
-    device->setPosition(validOutput); // Update position
+    return device->toValidPosition(scaledOutput);
+}
+
+void ArmLearnWrapper::startAction(uint64_t actionID) {
+    // the state in which the action is taken
+    if (recorder != nullptr) {
+        TrajectoryRecord &record = state.pendingRecord;
+        record.episode = recordedEpisode;
+        record.step = state.nbActions;
+        record.action = actionID;
+        std::copy(state.motorPos.getValues(), state.motorPos.getValues() + 6, record.motorPos);
+        std::copy(state.cartesianPos.getValues(), state.cartesianPos.getValues() + 3, record.cartesianPos);
+        std::copy(state.goal, state.goal + 3, record.goal);
+    }
+
+    auto position = computeActionPosition(actionID);
+    std::copy(position.begin(), position.end(), state.pendingPosition);
+    device->setPosition(position); // Update position
+}
+
+void ArmLearnWrapper::waitActionFeedback() {
     device->waitFeedback();
+}
+
+void ArmLearnWrapper::copyPredictedObservation(double *values) {
+    auto predictedCoords = converter->computeServoToCoord(
+            std::vector<uint16_t>(state.pendingPosition, state.pendingPosition + 6))->getCoord();
+    for (int i = 0; i < 3; i++) {
+        values[i] = state.goal[i] - predictedCoords[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        values[3 + i] = state.pendingPosition[i];
+    }
+}
 
+void ArmLearnWrapper::finishAction() {
     computeInput(); // to update  positions
 
-    nbActions++;
+    state.nbActions++;
 
     auto reward = computeReward(); // Computation of reward
 
+    state.score = reward;
 
+    if (recorder != nullptr) {
+        state.pendingRecord.reward = reward;
+        recorder->record(state.pendingRecord);
+    }
 
-    score = reward;
+    if (episodeLength > 0) {
+        detectCycle(reward);
+    }
+}
+
+void ArmLearnWrapper::detectCycle(double reward) {
+    // FNV-1a hash of the servo positions
+    uint64_t hash = 14695981039346656037ULL;
+    uint16_t motors[6];
+    for (int i = 0; i < 6; i++) {
+        motors[i] = (uint16_t) state.motorPos.getValues()[i];
+        hash ^= motors[i];
+        hash *= 1099511628211ULL;
+    }
+
+    uint64_t step = state.nbActions;
+    if (step < episodeLength) {
+        for (uint64_t period = 1; period <= std::min<uint64_t>(step, CYCLE_HISTORY); period++) {
+            const StateRecord &record = state.history[(step - period) % CYCLE_HISTORY];
+            if (record.hash == hash && std::equal(motors, motors + 6, record.motors)) {
+                // States from step - period repeat until the end of the episode
+                uint64_t cycleStart = step - period;
+                uint64_t finalStep = cycleStart + (episodeLength - cycleStart) % period;
+                state.score = state.history[finalStep % CYCLE_HISTORY].reward;
+                state.terminal = true;
+                break;
+            }
+        }
+    }
+
+    StateRecord &record = state.history[step % CYCLE_HISTORY];
+    record.hash = hash;
+    std::copy(motors, motors + 6, record.motors);
+    record.reward = reward;
 }
 
 double ArmLearnWrapper::computeReward() {
     std::vector<uint16_t> motorCoords;
-    for (int i = 0; i < motorPos.getLargestAddressSpace(); i++) {
-        motorCoords.emplace_back((uint16_t) *motorPos.getDataAt(typeid(double), i).getSharedPointer<const double>());
+    for (size_t i = 0; i < 6; i++) {
+        motorCoords.emplace_back((uint16_t) state.motorPos.getValues()[i]);
     }
     std::vector<double> cartesianCoords;
-    for (int i = 0; i < cartesianPos.getLargestAddressSpace(); i++) {
-        cartesianCoords.emplace_back(
-                (double) *cartesianPos.getDataAt(typeid(double), i).getSharedPointer<const double>());
+    for (size_t i = 0; i < 3; i++) {
+        cartesianCoords.emplace_back(state.cartesianPos.getValues()[i]);
     }
-    auto target = targets[0]->getInput();
+    auto target = targets[state.currentGoal]->getInput();
 
     if (!device->validPosition(motorCoords)) return VALID_COEFF;
 
@@ -126,29 +205,82 @@ void ArmLearnWrapper::reset(size_t seed, Learn::LearningMode mode) {
     device->goToBackhoe(); // Reset position
     device->waitFeedback();
 
-    swapGoal(1);
+    if (deterministicEvaluation && !targets.empty()) {
+        // the goal only depends on the seed, so any episode can be replayed on its own
+        state.currentGoal = seed % targets.size();
+    } else {
+        swapGoal(1);
+        state.currentGoal = 0;
+    }
+    for (int i = 0; i < 3; i++) {
+        state.goal[i] = targets[state.currentGoal]->getInput()[i];
+    }
 
     computeInput();
+    // the goal may have changed, all inputs are considered new
+    std::fill(state.inputChangeVersion, state.inputChangeVersion + ARM_OBSERVATION_SIZE, state.inputVersion);
 
-    score = 0;
-    nbActions = 0;
-    terminal = false;
+    state.score = 0;
+    state.nbActions = 0;
+    state.terminal = false;
+
+    if (recorder != nullptr) {
+        recordedEpisode = recorder->newEpisode();
+    }
+
+    if (episodeLength > 0) {
+        // the initial state may be revisited, with its own reward
+        detectCycle(computeReward());
+    }
 }
 
 std::vector<std::reference_wrapper<const Data::DataHandler>> ArmLearnWrapper::getDataSources() {
     auto result = std::vector<std::reference_wrapper<const Data::DataHandler>>();
-    result.emplace_back(cartesianDif);
-    result.emplace_back(motorPos);
+    result.emplace_back(state.cartesianDif);
+    result.emplace_back(state.motorPos);
     return result;
 }
 
+std::vector<double> ArmLearnWrapper::getObservation() const {
+    std::vector<double> result(ARM_OBSERVATION_SIZE);
+    copyObservation(result.data());
+    return result;
+}
+
+void ArmLearnWrapper::copyObservation(double *values) const {
+    for (int i = 0; i < 3; i++) {
+        values[i] = state.goal[i] - state.cartesianPos.getValues()[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        values[3 + i] = state.motorPos.getValues()[i];
+    }
+}
+
+uint64_t ArmLearnWrapper::getInputVersion() const {
+    return state.inputVersion;
+}
+
+uint64_t ArmLearnWrapper::getLastInputChange(uint16_t inputMask) const {
+    uint64_t lastChange = 0;
+    for (int i = 0; i < ARM_OBSERVATION_SIZE; i++) {
+        if ((inputMask >> i) & 1) {
+            lastChange = std::max(lastChange, state.inputChangeVersion[i]);
+        }
+    }
+    return lastChange;
+}
+
 double ArmLearnWrapper::getScore() const {
-    return score;
+    return state.score;
 }
 
+double ArmLearnWrapper::getEpisodeScoreUpperBound() const {
+    // a null error, the goal is reached exactly
+    return 0.0;
+}
 
 bool ArmLearnWrapper::isTerminal() const {
-    return terminal;
+    return state.terminal;
 }
 
 bool ArmLearnWrapper::isCopyable() const {
@@ -161,11 +293,46 @@ void ArmLearnWrapper::swapGoal(int i) {
     std::rotate(targets.begin(), targets.begin() + i, targets.end());
 }
 
+void ArmLearnWrapper::setDeterministicEvaluation(bool deterministic) {
+    deterministicEvaluation = deterministic;
+}
+
+bool ArmLearnWrapper::isDeterministic() const {
+    return deterministicEvaluation;
+}
+
+uint64_t ArmLearnWrapper::getNbEvaluationEpisodes() const {
+    return deterministicEvaluation ? targets.size() : 1;
+}
+
+void ArmLearnWrapper::setEpisodeLength(uint64_t length) {
+    episodeLength = length;
+}
+
+uint64_t ArmLearnWrapper::getEpisodeLength() const {
+    return episodeLength;
+}
+
+void ArmLearnWrapper::setRecorder(TrajectoryRecorder *trajectoryRecorder) {
+    recorder = trajectoryRecorder;
+}
+
+void ArmLearnWrapper::setController(armlearn::communication::AbstractController *controller) {
+    if (simulator == nullptr) {
+        simulator = device;
+    }
+    device = (controller != nullptr) ? controller : simulator;
+}
+
 armlearn::Input<uint16_t>* ArmLearnWrapper::randomGoal() {
     return new armlearn::Input<uint16_t>(
             {(uint16_t) (rng.getUnsignedInt64(50,350)), (uint16_t) (rng.getUnsignedInt64(50,350)), (uint16_t) (rng.getUnsignedInt64(20,300))});
 }
 
+void ArmLearnWrapper::setRandomSeed(size_t seed) {
+    rng.setSeed(seed);
+}
+
 void ArmLearnWrapper::customGoal(armlearn::Input<uint16_t>* newGoal) {
     targets.erase(targets.begin());
     targets.emplace(targets.begin(),newGoal);
@@ -174,9 +341,9 @@ void ArmLearnWrapper::customGoal(armlearn::Input<uint16_t>* newGoal) {
 std::string ArmLearnWrapper::newGoalToString() const {
     std::stringstream toLog;
     toLog << " - (new goal : ";
-    toLog << targets[0]->getInput()[0] << " ; ";
-    toLog << targets[0]->getInput()[1] << " ; ";
-    toLog << targets[0]->getInput()[2] << " ; ";
+    toLog << targets[state.currentGoal]->getInput()[0] << " ; ";
+    toLog << targets[state.currentGoal]->getInput()[1] << " ; ";
+    toLog << targets[state.currentGoal]->getInput()[2] << " ; ";
     toLog << ")" << std::endl;
     return toLog.str();
 }
@@ -184,19 +351,17 @@ std::string ArmLearnWrapper::newGoalToString() const {
 std::string ArmLearnWrapper::toString() const {
     std::stringstream res;
     for (int i = 0; i < 6; i++) {
-        double input = (double) *(this->motorPos.getDataAt(typeid(double), i).getSharedPointer<const double>());
-        res << input << " ; ";
+        res << state.motorPos.getValues()[i] << " ; ";
     }
 
     res << "    -->    ";
     for (int i = 0; i < 3; i++) {
-        double input = (double) *(this->cartesianPos.getDataAt(typeid(double), i).getSharedPointer<const double>());
-        res << input << " ; ";
+        res << state.cartesianPos.getValues()[i] << " ; ";
     }
     res << " - (goal : ";
-    res << targets[0]->getInput()[0] << " ; ";
-    res << targets[0]->getInput()[1] << " ; ";
-    res << targets[0]->getInput()[2] << " ; ";
+    res << targets[state.currentGoal]->getInput()[0] << " ; ";
+    res << targets[state.currentGoal]->getInput()[1] << " ; ";
+    res << targets[state.currentGoal]->getInput()[2] << " ; ";
     res << ")";
 
     return res.str();
@@ -12,6 +12,9 @@
 #include <armlearn/optimcartesianconverter.h>
 #include <armlearn/devicelearner.h>
 
+#include "InlineArray.h"
+#include "TrajectoryRecorder.h"
+
 // Proportion of target error in the reward
 #define TARGET_PROP 0.7
 // Coefficient of target error (difference between the real output and the target output, to minimize) when computing error between input and output
@@ -24,6 +27,10 @@
 #define LEARN_ERROR_MARGIN 0.005
 // Coefficient decreasing the reward for a state as the state is closer to the initial state
 #define DECREASING_REWARD 0.99
+// Number of values of the data sources: cartesianDif then motorPos
+#define ARM_OBSERVATION_SIZE 9
+// Number of previous states compared to the current one to detect cycles
+#define CYCLE_HISTORY 64
 
 /**
 * LearningEnvironment to use armLean in order to learn how to move a robotic arm.
@@ -34,25 +41,95 @@ protected:
 
     double computeReward();
 
-    bool terminal = false;
+    /// Servo state reached after an action, and its reward
+    struct StateRecord {
+        uint64_t hash;
+        uint16_t motors[6];
+        double reward;
+    };
 
-    /// Randomness control
-    Mutator::RNG rng;
+    /**
+    * \brief State of the environment written at each step.
+    *
+    * All of it is stored inline, the data sources included, in a block
+    * aligned on cache lines and padded to a whole number of lines. A clone
+    * thus writes no memory that another object can share a line with, even
+    * when clones are allocated back-to-back by the same thread. Data only
+    * read during episodes (goals, converter, device) is kept out of it.
+    */
+    struct alignas(64) EpisodeState {
+        /// Current arm position, data source
+        InlineArray<6> motorPos;
+
+        /// Current arm position
+        InlineArray<3> cartesianPos;
+
+        /// Current arm and goal distance vector, data source
+        InlineArray<3> cartesianDif;
+
+        /// Coordinates of the goal of the current episode
+        double goal[3] = {0};
 
-    /// Current arm position
-    Data::PrimitiveTypeArray<double> motorPos;
+        double score = 0;
+
+        size_t nbActions = 0;
+
+        /// Index in targets of the goal of the current episode
+        size_t currentGoal = 0;
+
+        bool terminal = false;
+
+        /// Incremented each time the inputs are computed
+        uint64_t inputVersion = 0;
+
+        /// Value of inputVersion when each value of getObservation() last changed
+        uint64_t inputChangeVersion[ARM_OBSERVATION_SIZE] = {0};
+
+        /// Position sent by startAction()
+        uint16_t pendingPosition[6] = {0};
+
+        /// Record of the step started by startAction(), written by finishAction()
+        TrajectoryRecord pendingRecord = {};
+
+        /// Last CYCLE_HISTORY states of the episode, indexed by their step modulo CYCLE_HISTORY
+        StateRecord history[CYCLE_HISTORY] = {};
+    };
 
-    /// Current arm position
-    Data::PrimitiveTypeArray<double> cartesianPos;
+    /// Hot state, first member so that it directly follows the read-only base classes
+    EpisodeState state;
 
-    /// Current arm and goal distance vector
-    Data::PrimitiveTypeArray<double> cartesianDif;
+    /// Number of actions of an episode, 0 to disable cycle detection
+    uint64_t episodeLength = 0;
+
+    /**
+    * \brief Records the current state and ends the episode if it was already visited.
+    *
+    * The policy and the simulator are deterministic, so once a servo state
+    * is revisited L steps later, the episode repeats these L states until its
+    * end. The score of the episode is then the reward of the state reached at
+    * episodeLength, taken from the history.
+    */
+    void detectCycle(double reward);
 
     armlearn::kinematics::Converter *converter;
 
-    double score = 0;
+    /// Randomness control
+    Mutator::RNG rng;
+
+    /// When true, reset(seed) picks the goal from the seed instead of rotating the goal set
+    bool deterministicEvaluation = false;
+
+    /// Recorder of the steps of episodes, nullptr to record nothing
+    TrajectoryRecorder *recorder = nullptr;
+
+    /// Identifier of the current episode in the recorder
+    uint64_t recordedEpisode = 0;
+
+    /// Absolute servo positions reached by an action from the current state
+    std::vector<uint16_t> computeActionPosition(uint64_t actionID) const;
 
-    size_t nbActions = 0;
+    /// Simulator created by iniController(), when the device was replaced by setController()
+    armlearn::communication::AbstractController *simulator = nullptr;
 
 public:
 
@@ -82,8 +159,7 @@ public:
     * Constructor.
     */
     ArmLearnWrapper(int* gen)
-            : LearningEnvironment(13), targets(1), motorPos(6), cartesianPos(3), cartesianDif(3),
-              DeviceLearner(iniController()) {
+            : LearningEnvironment(13), targets(1), DeviceLearner(iniController()) {
 
 /*
         auto goal1 = new armlearn::Input<uint16_t>({0, 247, 267});
@@ -103,10 +179,15 @@ public:
 /**
 * \brief Copy constructor for the armLearnWrapper.
 *
+* The copy owns its simulator, converter and data handlers, so that copies can
+* run episodes concurrently. Only the goals pointed by targets, which are never
+* modified, are shared with the original.
 */
-    ArmLearnWrapper(const ArmLearnWrapper &other) : Learn::LearningEnvironment(other.nbActions), targets(other.targets),
-                                                    motorPos(other.motorPos), cartesianPos(other.cartesianPos),
-                                                    cartesianDif(other.cartesianDif), DeviceLearner(iniController()) {
+    ArmLearnWrapper(const ArmLearnWrapper &other) : Learn::LearningEnvironment(other.getNbActions()),
+                                                    DeviceLearner(iniController()), state(other.state),
+                                                    episodeLength(other.episodeLength),
+                                                    deterministicEvaluation(other.deterministicEvaluation),
+                                                    recorder(other.recorder), targets(other.targets) {
 
         this->reset(0);
         computeInput();
@@ -114,14 +195,37 @@ public:
 
 /// Destructor
     ~ArmLearnWrapper() {
-        delete this->device;
+        delete ((simulator != nullptr) ? simulator : this->device);
         delete this->converter;
     };
 
 
-/// Inherited via LearningEnvironment
+/// Inherited via LearningEnvironment, startAction(), waitActionFeedback() then finishAction()
     void doAction(uint64_t actionID) override;
 
+/**
+* \brief Sends the position reached by the action to the device, without waiting for it.
+*
+* Steps can be split so that the next decision is computed while the arm
+* moves: startAction(), then waitActionFeedback(), possibly on another
+* thread, then finishAction() once the arm stopped. Only
+* waitActionFeedback() may run concurrently with other calls.
+*/
+    void startAction(uint64_t actionID);
+
+/// Waits until the device reached the position sent by startAction()
+    void waitActionFeedback();
+
+/// Updates the inputs, score and recorder with the state reached by the action of startAction()
+    void finishAction();
+
+/**
+* \brief Observation expected once the position sent by startAction() is reached.
+*
+* Same layout as copyObservation(), computed without the device.
+*/
+    void copyPredictedObservation(double *values);
+
 
 /// Inherited via LearningEnvironment
     void reset(size_t seed = 0, Learn::LearningMode mode = Learn::LearningMode::TRAINING) override;
@@ -129,6 +233,23 @@ public:
 /// Inherited via LearningEnvironment
     std::vector<std::reference_wrapper<const Data::DataHandler>> getDataSources() override;
 
+/// Returns the current values of the data sources, cartesianDif followed by motorPos
+    std::vector<double> getObservation() const;
+
+/// Copies the ARM_OBSERVATION_SIZE values of getObservation() without allocating
+    void copyObservation(double *values) const;
+
+/// Version of the current inputs, incremented at each step and reset
+    uint64_t getInputVersion() const;
+
+/**
+* \brief Last version at which one of the given inputs changed.
+*
+* \param[in] inputMask bit i is set for the value i of getObservation().
+* All inputs change when an episode starts.
+*/
+    uint64_t getLastInputChange(uint16_t inputMask) const;
+
 /**
 * Inherited from LearningEnvironment.
 *
@@ -138,6 +259,15 @@ public:
 */
     double getScore() const override;
 
+/**
+* \brief Upper bound of the final score of an episode.
+*
+* The score of an episode is the reward of its last state, the opposite of
+* an error to the goal, so no sequence of actions can score more than this
+* bound. Used to stop the evaluation of roots that can not survive.
+*/
+    double getEpisodeScoreUpperBound() const;
+
 /// Inherited via LearningEnvironment
     bool isTerminal() const override;
 
@@ -150,9 +280,57 @@ public:
 /// Changes the goal, putting the first of the vector to the end
     void swapGoal(int i);
 
+/**
+* \brief Enables or disables the deterministic evaluation mode.
+*
+* The simulator is deterministic, so replaying a goal always gives the same
+* score. In this mode, reset(seed) selects the goal targets[seed % targets.size()]
+* instead of rotating the goal set, and one evaluation is a single pass over
+* the current goals (see getNbEvaluationEpisodes()).
+*/
+    void setDeterministicEvaluation(bool deterministic);
+
+/// Returns true when episodes only depend on the seed given to reset()
+    bool isDeterministic() const;
+
+/// Number of distinct episodes in deterministic mode, i.e. the number of goals
+    uint64_t getNbEvaluationEpisodes() const;
+
+/**
+* \brief Sets the number of actions of an episode, enabling cycle detection.
+*
+* When the arm comes back to a servo state visited in the last
+* CYCLE_HISTORY steps, or stays still, the episode ends immediately with the
+* score it would have after episodeLength actions. 0 disables the detection.
+*/
+    void setEpisodeLength(uint64_t length);
+
+/// Number of actions of an episode given to setEpisodeLength(), 0 if cycle detection is disabled
+    uint64_t getEpisodeLength() const;
+
+/**
+* \brief Records each step of the next episodes, nullptr to stop recording.
+*
+* Clones record in the same recorder, which must outlive them.
+*/
+    void setRecorder(TrajectoryRecorder *trajectoryRecorder);
+
+/**
+* \brief Moves the arm with the given controller instead of the simulator.
+*
+* The controller must be built for the WidowX and connected, e.g. a
+* SerialController on the real arm or on an ArbotixEmulator, and outlive the
+* environment. Clones keep moving their own simulator. nullptr goes back to
+* the simulator.
+*/
+    void setController(armlearn::communication::AbstractController *controller);
+
 /// Generation a new  random
     armlearn::Input<uint16_t> *randomGoal();
 
+/// Sets the seed of the random goal generation
+    void setRandomSeed(size_t seed);
+
 /// Gives a custom goal to the environment
     void customGoal(armlearn::Input<uint16_t> *newGoal);
 
@@ -0,0 +1,50 @@
+#include "ArmLearnWrapperBatch.h"
+
+ArmLearnWrapperBatch::ArmLearnWrapperBatch(const ArmLearnWrapper &wrapper) {
+    for (size_t lane = 0; lane < LANE_WIDTH; lane++) {
+        lanes.emplace_back((ArmLearnWrapper *) wrapper.clone());
+    }
+}
+
+void ArmLearnWrapperBatch::reset(uint64_t firstEpisode, size_t nbEpisodes, Learn::LearningMode mode) {
+    activeLanes = 0;
+    for (size_t lane = 0; lane < std::min<size_t>(nbEpisodes, LANE_WIDTH); lane++) {
+        lanes[lane]->reset(firstEpisode + lane, mode);
+        if (!lanes[lane]->isTerminal()) {
+            activeLanes |= 1u << lane;
+        }
+    }
+}
+
+uint32_t ArmLearnWrapperBatch::getActiveLanes() const {
+    return activeLanes;
+}
+
+void ArmLearnWrapperBatch::copyObservations(double *observations) const {
+    double laneObservation[ARM_OBSERVATION_SIZE];
+    for (size_t lane = 0; lane < LANE_WIDTH; lane++) {
+        if (((activeLanes >> lane) & 1) == 0) {
+            continue;
+        }
+        lanes[lane]->copyObservation(laneObservation);
+        for (size_t i = 0; i < ARM_OBSERVATION_SIZE; i++) {
+            observations[i * LANE_WIDTH + lane] = laneObservation[i];
+        }
+    }
+}
+
+void ArmLearnWrapperBatch::doActions(const uint64_t *actions) {
+    for (size_t lane = 0; lane < LANE_WIDTH; lane++) {
+        if (((activeLanes >> lane) & 1) == 0) {
+            continue;
+        }
+        lanes[lane]->doAction(actions[lane]);
+        if (lanes[lane]->isTerminal()) {
+            activeLanes &= ~(1u << lane);
+        }
+    }
+}
+
+const ArmLearnWrapper &ArmLearnWrapperBatch::getLane(size_t lane) const {
+    return *lanes.at(lane);
+}
@@ -0,0 +1,57 @@
+#ifndef ARMGEGELATI_ARMLEARNWRAPPERBATCH_H
+#define ARMGEGELATI_ARMLEARNWRAPPERBATCH_H
+
+#include <memory>
+#include <vector>
+
+#include "ArmLearnWrapper.h"
+
+// Maximum number of arms stepped together, one bit each in a lane mask
+#define LANE_WIDTH 8
+
+/**
+* \brief Group of LANE_WIDTH arms stepped together.
+*
+* Each lane is a clone of an ArmLearnWrapper running its own episode. The
+* observations of all lanes are laid out column-wise, value i of
+* ArmLearnWrapper::getObservation() for lane l being at
+* i * LANE_WIDTH + l, so that an instruction reads a value of all lanes
+* from consecutive memory.
+*
+* Lanes whose episode is terminal are removed from the active lanes and no
+* longer stepped. As for ArmLearningAgent clones, the goals of the wrapper
+* are shared, so a batch must not outlive the generation of its goals.
+*/
+class ArmLearnWrapperBatch {
+protected:
+    std::vector<std::unique_ptr<ArmLearnWrapper>> lanes;
+
+    /// Bit l is set while the episode of lane l is running
+    uint32_t activeLanes = 0;
+
+public:
+    /// Clones the wrapper in each lane
+    explicit ArmLearnWrapperBatch(const ArmLearnWrapper &wrapper);
+
+    /**
+    * \brief Starts the episodes firstEpisode to firstEpisode + nbEpisodes - 1.
+    *
+    * Episode firstEpisode + l runs on lane l, see ArmLearnWrapper::reset().
+    * Lanes above nbEpisodes stay inactive.
+    */
+    void reset(uint64_t firstEpisode, size_t nbEpisodes, Learn::LearningMode mode);
+
+    /// Mask of the lanes whose episode is running
+    uint32_t getActiveLanes() const;
+
+    /// Copies the observations of all lanes, ARM_OBSERVATION_SIZE rows of LANE_WIDTH values
+    void copyObservations(double *observations) const;
+
+    /// Applies actions[l] to each active lane l, and deactivates lanes reaching a terminal state
+    void doActions(const uint64_t *actions);
+
+    /// Wrapper of a lane
+    const ArmLearnWrapper &getLane(size_t lane) const;
+};
+
+#endif //ARMGEGELATI_ARMLEARNWRAPPERBATCH_H
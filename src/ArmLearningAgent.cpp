@@ -0,0 +1,540 @@
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <thread>
+
+#include "ArmLearningAgent.h"
+
+ArmLearningAgent::ArmLearningAgent(ArmLearnWrapper &le, const Instructions::Set &iSet,
+                                   const Learn::LearningParameters &p) : ParallelLearningAgent(le, iSet, p),
+                                                                         armLearnWrapper(le) {
+}
+
+void ArmLearningAgent::setIntraRootParallelism(bool enabled) {
+    intraRootParallelism = enabled;
+}
+
+void ArmLearningAgent::setEvaluationScheduler(EvaluationScheduler type) {
+    if (type != schedulerType) {
+        scheduler.reset();
+    }
+    schedulerType = type;
+}
+
+void ArmLearningAgent::setThreadPlacement(const ThreadPlacement &placement) {
+    threadPlacement = placement;
+}
+
+void ArmLearningAgent::setShardedEvaluator(ShardedEvaluator *evaluator) {
+    shardedEvaluator = evaluator;
+}
+
+void ArmLearningAgent::setRacing(bool enabled, double confidence) {
+    racing = enabled;
+    racingConfidence = std::min(std::max(confidence, 0.5), 1.0);
+}
+
+uint64_t ArmLearningAgent::getNbRacingCutEpisodes() const {
+    return nbRacingCutEpisodes;
+}
+
+void ArmLearningAgent::setDeduplication(bool enabled, uint64_t nbObservations) {
+    deduplication = enabled;
+    if (nbObservations != nbProbeObservations) {
+        observationProbe.reset();
+    }
+    nbProbeObservations = nbObservations;
+}
+
+double ArmLearningAgent::getDeduplicationRatio() const {
+    return (nbRootsToEvaluate > 0) ? (double) nbDuplicateRoots / (double) nbRootsToEvaluate : 0.0;
+}
+
+std::vector<size_t> ArmLearningAgent::getRepresentatives(const std::vector<const TPG::TPGVertex *> &roots,
+                                                         Learn::LearningMode mode) {
+    std::vector<size_t> representatives(roots.size());
+    std::iota(representatives.begin(), representatives.end(), 0);
+    nbDuplicateRoots = 0;
+    nbRootsToEvaluate = 0;
+    if (!deduplication || mode != Learn::LearningMode::TRAINING) {
+        return representatives;
+    }
+
+    if (observationProbe == nullptr) {
+        observationProbe.reset(new ObservationProbe(this->env.getInstructionSet(), this->env.getNbRegisters()));
+        observationProbe->record(armLearnWrapper, nbProbeObservations, 0);
+    }
+
+    std::unordered_map<std::vector<uint64_t>, size_t, ActionSignatureHash> representativeOfSignature;
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        std::shared_ptr<Learn::EvaluationResult> previousEval;
+        if (this->isRootEvalSkipped(*roots[rootIdx], previousEval)) {
+            continue;
+        }
+        nbRootsToEvaluate++;
+        if (this->resultsPerRoot.count(roots[rootIdx]) > 0) {
+            continue;
+        }
+        auto inserted = representativeOfSignature.emplace(observationProbe->getActionSignature(*roots[rootIdx]),
+                                                          rootIdx);
+        if (!inserted.second) {
+            representatives[rootIdx] = inserted.first->second;
+            nbDuplicateRoots++;
+        }
+    }
+    return representatives;
+}
+
+void ArmLearningAgent::copyRepresentativeResults(const std::vector<size_t> &representatives,
+                                                 std::vector<std::shared_ptr<Learn::EvaluationResult>> &rootResults) const {
+    for (size_t rootIdx = 0; rootIdx < representatives.size(); rootIdx++) {
+        auto &representativeResult = rootResults[representatives[rootIdx]];
+        if (representatives[rootIdx] != rootIdx && representativeResult != nullptr) {
+            rootResults[rootIdx] = std::make_shared<Learn::EvaluationResult>(representativeResult->getResult(),
+                                                                             representativeResult->getNbEvaluation());
+        }
+    }
+}
+
+void ArmLearningAgent::setDecisionMemoization(bool enabled) {
+    decisionMemoization = enabled;
+}
+
+void ArmLearningAgent::setIncrementalExecution(bool enabled) {
+    incrementalExecution = enabled;
+}
+
+void ArmLearningAgent::setJit(bool enabled, uint64_t minAge, const std::string &compiler,
+                              const std::string &directory) {
+    if (enabled) {
+        jit.reset(new ProgramJit(minAge, compiler, directory));
+    } else {
+        jit.reset();
+    }
+}
+
+size_t ArmLearningAgent::getNbCompiledPrograms() const {
+    return (jit != nullptr) ? jit->getNbCompiledPrograms() : 0;
+}
+
+void ArmLearningAgent::setLaneExecution(bool enabled) {
+    laneExecution = enabled;
+}
+
+TPG::TPGExecutionEngine *ArmLearningAgent::createExecutionEngine(const Environment &env,
+                                                                 const ArmLearnWrapper &wrapper) const {
+    if (laneExecution && wrapper.isDeterministic()) {
+        return new LaneExecutionEngine(env, wrapper);
+    }
+    MemoizingExecutionEngine *tee;
+    if (incrementalExecution) {
+        tee = new IncrementalExecutionEngine(env, decisionMemoization ? 1 << 16 : 0);
+    } else if (decisionMemoization || jit != nullptr) {
+        tee = new MemoizingExecutionEngine(env, decisionMemoization ? 1 << 16 : 0);
+    } else {
+        return new TPG::TPGExecutionEngine(env);
+    }
+    tee->setJit(jit.get());
+    return tee;
+}
+
+void ArmLearningAgent::setForkedEvaluation(bool enabled) {
+    if (enabled) {
+        forkedEvaluator.reset(new ForkedEvaluator(this->maxNbThreads, threadPlacement));
+    } else {
+        forkedEvaluator.reset();
+    }
+}
+
+void ArmLearningAgent::setParameters(const ArmLearnParameters &armParams) {
+    setIntraRootParallelism(armParams.intraRootParallelism);
+    setEvaluationScheduler(armParams.scheduler == "workStealing" ? EvaluationScheduler::WORK_STEALING
+                                                                 : EvaluationScheduler::PARALLEL_LOOP);
+    if (armParams.pinThreads) {
+        setThreadPlacement(ThreadPlacement(armParams.cpus, armParams.scatterThreads));
+    }
+    setForkedEvaluation(armParams.forkedEvaluation);
+    setRacing(armParams.racing, armParams.racingConfidence);
+    setDeduplication(armParams.deduplication, armParams.nbProbeObservations);
+    setDecisionMemoization(armParams.decisionMemoization);
+    setIncrementalExecution(armParams.incrementalExecution);
+    setJit(armParams.jit, armParams.jitMinAge, armParams.jitCompiler, armParams.jitDirectory);
+    setLaneExecution(armParams.laneExecution);
+    // Clones made for evaluation inherit the episode length
+    armLearnWrapper.setEpisodeLength(armParams.cycleDetection ? this->params.maxNbActionsPerEval : 0);
+}
+
+std::vector<JobScheduler::WorkerStats> ArmLearningAgent::getWorkerStats() const {
+    if (scheduler == nullptr) {
+        return {};
+    }
+    return scheduler->getWorkerStats();
+}
+
+uint64_t ArmLearningAgent::getNbDeterministicEpisodes(const ArmLearnWrapper &wrapper) const {
+    // One episode per goal, further iterations would replay the same episodes
+    return std::min(wrapper.getNbEvaluationEpisodes(), this->params.nbIterationsPerPolicyEvaluation);
+}
+
+double ArmLearningAgent::evaluateEpisode(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t episode,
+                                         Learn::LearningMode mode, Learn::LearningEnvironment &le) const {
+    return runEpisode(tee, root, episode, mode, le, this->params.maxNbActionsPerEval);
+}
+
+double ArmLearningAgent::runEpisode(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t episode,
+                                    Learn::LearningMode mode, Learn::LearningEnvironment &le, uint64_t maxNbActions) {
+    // the seed selects the goal of the episode
+    le.reset(episode, mode);
+
+    // Remembered decisions need the observation of an ArmLearnWrapper
+    auto memoizingTee = dynamic_cast<MemoizingExecutionEngine *>(&tee);
+    auto wrapper = dynamic_cast<const ArmLearnWrapper *>(&le);
+    if (wrapper == nullptr) {
+        memoizingTee = nullptr;
+    }
+
+    uint64_t nbActions = 0;
+    while (!le.isTerminal() && nbActions < maxNbActions) {
+        uint64_t actionID = (memoizingTee != nullptr) ? memoizingTee->executeDecision(root, *wrapper)
+                                                      : ((const TPG::TPGAction *) tee.executeFromRoot(
+                        root).back())->getActionID();
+        le.doAction(actionID);
+        nbActions++;
+    }
+
+    return le.getScore();
+}
+
+void ArmLearningAgent::runLaneEpisodes(LaneExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t firstEpisode,
+                                       size_t nbEpisodes, Learn::LearningMode mode, uint64_t maxNbActions,
+                                       double *scores) {
+    ArmLearnWrapperBatch &batch = tee.getBatch();
+    batch.reset(firstEpisode, nbEpisodes, mode);
+
+    double observations[ARM_OBSERVATION_SIZE * LANE_WIDTH] = {0};
+    uint64_t actions[LANE_WIDTH] = {0};
+    uint64_t nbActions = 0;
+    while (batch.getActiveLanes() != 0 && nbActions < maxNbActions) {
+        batch.copyObservations(observations);
+        tee.executeFromRoot(root, observations, batch.getActiveLanes(), actions);
+        batch.doActions(actions);
+        nbActions++;
+    }
+
+    for (size_t lane = 0; lane < std::min<size_t>(nbEpisodes, LANE_WIDTH); lane++) {
+        scores[lane] = batch.getLane(lane).getScore();
+    }
+}
+
+std::shared_ptr<Learn::EvaluationResult>
+ArmLearningAgent::evaluateJob(TPG::TPGExecutionEngine &tee, const Learn::Job &job, uint64_t generationNumber,
+                              Learn::LearningMode mode, Learn::LearningEnvironment &le) const {
+    auto wrapper = dynamic_cast<ArmLearnWrapper *>(&le);
+    if (wrapper == nullptr || !wrapper->isDeterministic()) {
+        return Learn::ParallelLearningAgent::evaluateJob(tee, job, generationNumber, mode, le);
+    }
+
+    const TPG::TPGVertex *root = job.getRoot();
+
+    // Skip the root evaluation process if enough evaluations were already performed.
+    std::shared_ptr<Learn::EvaluationResult> previousEval;
+    if (mode == Learn::LearningMode::TRAINING && this->isRootEvalSkipped(*root, previousEval)) {
+        if (racing) {
+            racingThreshold.addResult(previousEval->getResult());
+        }
+        return previousEval;
+    }
+
+    uint64_t nbEpisodes = getNbDeterministicEpisodes(*wrapper);
+    bool race = racing && mode == Learn::LearningMode::TRAINING;
+
+    // Episodes run LANE_WIDTH at a time on the lanes of a LaneExecutionEngine
+    auto laneTee = dynamic_cast<LaneExecutionEngine *>(&tee);
+    double laneScores[LANE_WIDTH];
+
+    double result = 0.0;
+    double sumSquares = 0.0;
+    for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+        double score;
+        if (laneTee != nullptr) {
+            if (episode % LANE_WIDTH == 0) {
+                runLaneEpisodes(*laneTee, *root, episode, std::min<uint64_t>(LANE_WIDTH, nbEpisodes - episode), mode,
+                                this->params.maxNbActionsPerEval, laneScores);
+            }
+            score = laneScores[episode % LANE_WIDTH];
+        } else {
+            score = evaluateEpisode(tee, *root, episode, mode, le);
+        }
+        result += score;
+        sumSquares += score * score;
+
+        if (race && episode + 1 < nbEpisodes) {
+            double threshold = racingThreshold.getThreshold();
+            if (threshold == -std::numeric_limits<double>::infinity()) {
+                continue;
+            }
+            auto bound = std::make_shared<Learn::EvaluationResult>(
+                    getRacingUpperBound(result, sumSquares, episode + 1, nbEpisodes, *wrapper), nbEpisodes);
+            if (previousEval != nullptr) {
+                *bound += *previousEval;
+            }
+            if (bound->getResult() < threshold) {
+                // The root can not survive, its bound is enough to decimate it
+                nbRacingCutEpisodes += nbEpisodes - (episode + 1);
+                return bound;
+            }
+        }
+    }
+
+    auto evaluationResult = std::make_shared<Learn::EvaluationResult>(result / (double) nbEpisodes, nbEpisodes);
+
+    // Combine it with previous one if any
+    if (previousEval != nullptr) {
+        *evaluationResult += *previousEval;
+    }
+    if (race) {
+        racingThreshold.addResult(evaluationResult->getResult());
+    }
+    return evaluationResult;
+}
+
+double ArmLearningAgent::getRacingUpperBound(double sum, double sumSquares, uint64_t nbDone, uint64_t nbEpisodes,
+                                             const ArmLearnWrapper &wrapper) const {
+    uint64_t nbRemaining = nbEpisodes - nbDone;
+    double remainingBound = wrapper.getEpisodeScoreUpperBound();
+
+    if (racingConfidence < 1.0 && nbDone >= 2) {
+        double mean = sum / (double) nbDone;
+        double variance = std::max(0.0, (sumSquares - sum * mean) / (double) (nbDone - 1));
+        double z = normalQuantile(racingConfidence);
+        // Error on the mean of finished episodes and on the mean of remaining ones
+        double margin = z * std::sqrt(variance * (1.0 / (double) nbDone + 1.0 / (double) nbRemaining));
+        remainingBound = std::min(remainingBound, mean + margin);
+    }
+
+    return (sum + remainingBound * (double) nbRemaining) / (double) nbEpisodes;
+}
+
+std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *>
+ArmLearningAgent::evaluateAllRoots(uint64_t generationNumber, Learn::LearningMode mode) {
+    uint64_t nbEpisodes = getNbDeterministicEpisodes(armLearnWrapper);
+
+    nbRacingCutEpisodes = 0;
+    bool race = racing && mode == Learn::LearningMode::TRAINING;
+    if (race) {
+        // Roots removed by the decimation, see Learn::LearningAgent::decimateWorstRoots()
+        auto nbDeleted = (uint64_t) std::floor(this->params.ratioDeletedRoots * this->params.mutation.tpg.nbRoots);
+        uint64_t nbRoots = this->tpg.getNbRootVertices();
+        racingThreshold.reset(nbRoots > nbDeleted ? nbRoots - nbDeleted : 0);
+    }
+
+    auto roots = this->tpg.getRootVertices();
+    std::vector<size_t> representatives = getRepresentatives(roots, mode);
+    bool deduplicate = deduplication && mode == Learn::LearningMode::TRAINING;
+
+    if (shardedEvaluator != nullptr && shardedEvaluator->isListening() && armLearnWrapper.isDeterministic()
+        && nbEpisodes > 0) {
+        scheduler.reset();
+        std::unique_ptr<TPG::TPGExecutionEngine> localTee(createExecutionEngine(this->env, armLearnWrapper));
+        return evaluateAllRootsOutOfProcess(mode, nbEpisodes, representatives, [&](const std::vector<const TPG::TPGVertex *> &roots) {
+            return shardedEvaluator->evaluate(roots, armLearnWrapper.targets, mode, nbEpisodes,
+                                              this->params.maxNbActionsPerEval, armLearnWrapper.getEpisodeLength(),
+                                              [&](const TPG::TPGVertex &root) {
+                        return evaluateRootLocally(*localTee, root, nbEpisodes, mode);
+                    });
+        });
+    }
+
+    if (forkedEvaluator != nullptr && armLearnWrapper.isDeterministic() && nbEpisodes > 0) {
+        scheduler.reset();
+        std::unique_ptr<TPG::TPGExecutionEngine> localTee(createExecutionEngine(this->env, armLearnWrapper));
+        return evaluateAllRootsOutOfProcess(mode, nbEpisodes, representatives, [&](const std::vector<const TPG::TPGVertex *> &roots) {
+            return forkedEvaluator->evaluate(roots, armLearnWrapper, this->env, mode, nbEpisodes,
+                                             this->params.maxNbActionsPerEval, [&](const TPG::TPGVertex &root) {
+                        return evaluateRootLocally(*localTee, root, nbEpisodes, mode);
+                    });
+        });
+    }
+
+    // Racing needs the episodes of a root to be evaluated one after the other
+    // Lanes run the episodes of a root together
+    bool episodeJobs = intraRootParallelism && !race && !laneExecution && armLearnWrapper.isDeterministic()
+                       && nbEpisodes > 0 && this->maxNbThreads > 1;
+    // Scheduling options only matter with several threads
+    bool customScheduling = episodeJobs || ((schedulerType == EvaluationScheduler::WORK_STEALING
+                                             || threadPlacement.isEnabled()) && this->maxNbThreads > 1);
+    // The gegelati loop uses plain engines and evaluates all roots, including duplicates
+    bool customEngine = decisionMemoization || incrementalExecution || jit != nullptr || laneExecution;
+    if (!customScheduling && !customEngine && !deduplicate) {
+        scheduler.reset();
+        return Learn::ParallelLearningAgent::evaluateAllRoots(generationNumber, mode);
+    }
+
+    // Only the engines of evaluation threads execute compiled programs
+    if (jit != nullptr) {
+        jit->update(this->tpg, this->env, generationNumber);
+    }
+
+    // Select roots to evaluate and draw archive seeds in root order, so that
+    // results do not depend on the number of threads.
+    std::vector<std::shared_ptr<Learn::EvaluationResult>> rootResults(roots.size());
+    std::vector<bool> skipped(roots.size(), false);
+    std::map<uint64_t, Archive *> archiveMap;
+    std::vector<std::pair<size_t, uint64_t>> jobs;
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        if (mode == Learn::LearningMode::TRAINING) {
+            skipped[rootIdx] = this->isRootEvalSkipped(*roots[rootIdx], rootResults[rootIdx]);
+            if (skipped[rootIdx]) {
+                if (race) {
+                    racingThreshold.addResult(rootResults[rootIdx]->getResult());
+                }
+                continue;
+            }
+        }
+        if (representatives[rootIdx] != rootIdx) {
+            continue;
+        }
+        if (mode == Learn::LearningMode::TRAINING) {
+            archiveMap[rootIdx] = new Archive(this->params.archiveSize, this->params.archivingProbability,
+                                              this->rng.getUnsignedInt64(0, UINT64_MAX));
+        }
+        if (episodeJobs) {
+            for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+                jobs.emplace_back(rootIdx, episode);
+            }
+        } else {
+            jobs.emplace_back(rootIdx, 0);
+        }
+    }
+
+    // Custom engines are also used with a single thread
+    uint64_t nbWorkers = std::max<uint64_t>(this->maxNbThreads, 1);
+    if (scheduler == nullptr || scheduler->getNbWorkers() != nbWorkers) {
+        if (schedulerType == EvaluationScheduler::WORK_STEALING) {
+            scheduler.reset(new WorkStealingScheduler(nbWorkers));
+        } else {
+            scheduler.reset(new SharedCounterScheduler(nbWorkers));
+        }
+    }
+
+    std::vector<double> scores(episodeJobs ? roots.size() * nbEpisodes : 0, 0.0);
+
+    auto worker = [&](size_t workerIdx) {
+        // Pin the worker before it allocates its data, so that it lands on its NUMA node
+        threadPlacement.pinCurrentThread(workerIdx);
+
+        // Each worker owns its environment, so that episodes do not share any state
+        std::unique_ptr<Learn::LearningEnvironment> privateLe(armLearnWrapper.clone());
+        Environment privateEnv(this->env.getInstructionSet(), privateLe->getDataSources(),
+                               this->env.getNbRegisters());
+        std::unique_ptr<TPG::TPGExecutionEngine> privateTee(
+                createExecutionEngine(privateEnv, (const ArmLearnWrapper &) *privateLe));
+        TPG::TPGExecutionEngine &tee = *privateTee;
+
+        size_t jobIdx;
+        while (scheduler->nextJob(workerIdx, jobIdx)) {
+            size_t rootIdx = jobs[jobIdx].first;
+            uint64_t episode = jobs[jobIdx].second;
+
+            // Only the first episode of a root feeds its archive, other episodes
+            // of the same root may run concurrently on other workers.
+            auto archive = archiveMap.find(rootIdx);
+            tee.setArchive((episode == 0 && archive != archiveMap.end()) ? archive->second : NULL);
+
+            if (episodeJobs) {
+                scores[rootIdx * nbEpisodes + episode] = evaluateEpisode(tee, *roots[rootIdx], episode, mode,
+                                                                         *privateLe);
+            } else {
+                Learn::Job job({roots[rootIdx]}, 0, rootIdx);
+                rootResults[rootIdx] = this->evaluateJob(tee, job, generationNumber, mode, *privateLe);
+            }
+        }
+    };
+
+    scheduler->start(jobs.size());
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < nbWorkers; i++) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    scheduler->stop();
+
+    // Reduce episode scores in a fixed order
+    std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *> results;
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        if (representatives[rootIdx] != rootIdx) {
+            // Behaviourally identical to a root already reduced
+            auto &representativeResult = rootResults[representatives[rootIdx]];
+            rootResults[rootIdx] = std::make_shared<Learn::EvaluationResult>(representativeResult->getResult(),
+                                                                             representativeResult->getNbEvaluation());
+        } else if (episodeJobs && !skipped[rootIdx]) {
+            double result = std::accumulate(scores.begin() + rootIdx * nbEpisodes,
+                                            scores.begin() + (rootIdx + 1) * nbEpisodes, 0.0);
+            auto evaluationResult = std::make_shared<Learn::EvaluationResult>(result / (double) nbEpisodes,
+                                                                              nbEpisodes);
+            // Combine it with previous one if any
+            if (rootResults[rootIdx] != nullptr) {
+                *evaluationResult += *rootResults[rootIdx];
+            }
+            rootResults[rootIdx] = evaluationResult;
+        }
+        results.emplace(rootResults[rootIdx], roots[rootIdx]);
+    }
+
+    // Merge the archives
+    this->archive.mergeArchiveMap(archiveMap);
+    for (auto &archive : archiveMap) {
+        delete archive.second;
+    }
+
+    return results;
+}
+
+double ArmLearningAgent::evaluateRootLocally(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root,
+                                             uint64_t nbEpisodes, Learn::LearningMode mode) {
+    double result = 0.0;
+    for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+        result += evaluateEpisode(tee, root, episode, mode, armLearnWrapper);
+    }
+    return result / (double) nbEpisodes;
+}
+
+std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *>
+ArmLearningAgent::evaluateAllRootsOutOfProcess(Learn::LearningMode mode, uint64_t nbEpisodes,
+                                               const std::vector<size_t> &representatives,
+                                               const std::function<std::vector<double>(
+                                                       const std::vector<const TPG::TPGVertex *> &)> &evaluateRoots) {
+    auto roots = this->tpg.getRootVertices();
+
+    std::vector<std::shared_ptr<Learn::EvaluationResult>> rootResults(roots.size());
+    std::vector<const TPG::TPGVertex *> evaluatedRoots;
+    std::vector<size_t> evaluatedIdx;
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        if ((mode != Learn::LearningMode::TRAINING || !this->isRootEvalSkipped(*roots[rootIdx], rootResults[rootIdx]))
+            && representatives[rootIdx] == rootIdx) {
+            evaluatedRoots.push_back(roots[rootIdx]);
+            evaluatedIdx.push_back(rootIdx);
+        }
+    }
+
+    std::vector<double> scores = evaluateRoots(evaluatedRoots);
+
+    for (size_t i = 0; i < evaluatedIdx.size(); i++) {
+        auto evaluationResult = std::make_shared<Learn::EvaluationResult>(scores[i], nbEpisodes);
+        // Combine it with previous one if any
+        if (rootResults[evaluatedIdx[i]] != nullptr) {
+            *evaluationResult += *rootResults[evaluatedIdx[i]];
+        }
+        rootResults[evaluatedIdx[i]] = evaluationResult;
+    }
+    copyRepresentativeResults(representatives, rootResults);
+
+    std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *> results;
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        results.emplace(rootResults[rootIdx], roots[rootIdx]);
+    }
+    return results;
+}
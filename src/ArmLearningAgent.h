@@ -0,0 +1,351 @@
+#ifndef ARMGEGELATI_ARMLEARNINGAGENT_H
+#define ARMGEGELATI_ARMLEARNINGAGENT_H
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+#include "ArmLearnParameters.h"
+#include "ForkedEvaluation.h"
+#include "JobScheduler.h"
+#include "IncrementalExecutionEngine.h"
+#include "LaneExecutionEngine.h"
+#include "ObservationProbe.h"
+#include "ProgramJit.h"
+#include "RacingThreshold.h"
+#include "ShardedEvaluation.h"
+#include "ThreadPlacement.h"
+
+/// Distribution of the root evaluation jobs on the threads of the ArmLearningAgent
+enum class EvaluationScheduler {
+    /// Default gegelati parallel loop over the roots
+    PARALLEL_LOOP,
+    /// Work-stealing over per-thread job queues, see WorkStealingScheduler
+    WORK_STEALING
+};
+
+/**
+* \brief ParallelLearningAgent specialized for the ArmLearnWrapper.
+*
+* When the evaluated ArmLearnWrapper is in deterministic mode, a root is
+* evaluated with a single pass over the goal set instead of
+* nbIterationsPerPolicyEvaluation episodes, since additional iterations would
+* replay identical episodes.
+*
+* With intra-root parallelism, the episodes of each root are also dispatched
+* as separate jobs on the workers, each worker owning a clone of the
+* ArmLearnWrapper, and the episode scores are reduced per root afterwards.
+*
+* Jobs are distributed either with the default gegelati parallel loop or with
+* a work-stealing scheduler, whose per-thread busy and idle times are kept
+* after each evaluation. Threads can be pinned on cpus, each thread then
+* building its environment clone and execution engine on its own NUMA node.
+*/
+class ArmLearningAgent : public Learn::ParallelLearningAgent {
+protected:
+    /// The environment given at construction, whose clones are used by workers
+    ArmLearnWrapper &armLearnWrapper;
+
+    /// When true, episodes of a root are evaluated in parallel
+    bool intraRootParallelism = false;
+
+    /// Distribution of jobs on threads
+    EvaluationScheduler schedulerType = EvaluationScheduler::PARALLEL_LOOP;
+
+    /// Scheduler of the last evaluation done by the ArmLearningAgent, if any
+    std::unique_ptr<JobScheduler> scheduler;
+
+    /// Cpus of the evaluation threads
+    ThreadPlacement threadPlacement;
+
+    /// When true, the evaluation of a root stops once it can not survive the decimation
+    bool racing = false;
+
+    /// Probability that a root whose evaluation stops would not have survived, 1 to only stop hopeless roots
+    double racingConfidence = 1.0;
+
+    /// Result to reach to survive the current generation
+    mutable RacingThreshold racingThreshold;
+
+    /// Number of episodes not evaluated thanks to racing since the last evaluation of all roots
+    mutable std::atomic<uint64_t> nbRacingCutEpisodes{0};
+
+    /**
+    * \brief Upper bound of the result of a root whose evaluation is not finished.
+    *
+    * With a racingConfidence of 1, each remaining episode is bounded by
+    * ArmLearnWrapper::getEpisodeScoreUpperBound(). Otherwise, after two
+    * episodes, the average of remaining episodes is also bounded by a
+    * one-sided normal confidence interval built from the finished ones.
+    *
+    * \param[in] sum sum of the scores of the nbDone finished episodes.
+    * \param[in] sumSquares sum of the squares of these scores.
+    * \return the bound of the average over nbEpisodes episodes.
+    */
+    double getRacingUpperBound(double sum, double sumSquares, uint64_t nbDone, uint64_t nbEpisodes,
+                               const ArmLearnWrapper &wrapper) const;
+
+    /// When true, behaviourally identical new roots are evaluated once per generation
+    bool deduplication = false;
+
+    /// Number of observations of the probe comparing roots
+    uint64_t nbProbeObservations = 64;
+
+    /// Probe comparing roots, recorded at the first deduplication
+    std::unique_ptr<ObservationProbe> observationProbe;
+
+    /// Number of roots whose evaluation was replaced by the one of an identical root, during the last evaluation
+    uint64_t nbDuplicateRoots = 0;
+
+    /// Number of roots that needed an evaluation, including duplicates, during the last evaluation
+    uint64_t nbRootsToEvaluate = 0;
+
+    /**
+    * \brief Groups roots by action signature.
+    *
+    * Only roots without previous evaluation are grouped, since their result
+    * only depends on this evaluation. Counts duplicates for
+    * getDeduplicationRatio().
+    *
+    * \return for each root, the index of the root evaluated in its place,
+    * itself if it is evaluated.
+    */
+    std::vector<size_t> getRepresentatives(const std::vector<const TPG::TPGVertex *> &roots,
+                                           Learn::LearningMode mode);
+
+    /// Gives to each duplicate root a copy of the result of its representative
+    void copyRepresentativeResults(const std::vector<size_t> &representatives,
+                                   std::vector<std::shared_ptr<Learn::EvaluationResult>> &rootResults) const;
+
+    /// When true, evaluation threads remember the decisions of the root they evaluate
+    bool decisionMemoization = false;
+
+    /// When true, evaluation threads only re-execute programs whose inputs changed
+    bool incrementalExecution = false;
+
+    /// When set, evaluation threads execute the programs it compiled natively
+    std::unique_ptr<ProgramJit> jit;
+
+    /// When true, evaluation threads run the episodes of a root on the lanes of a LaneExecutionEngine
+    bool laneExecution = false;
+
+    /**
+    * \brief Creates the execution engine of an evaluation thread, according to lane, memoization and JIT options.
+    *
+    * \param[in] wrapper environment of the thread, cloned in the lanes of a LaneExecutionEngine.
+    */
+    TPG::TPGExecutionEngine *createExecutionEngine(const Environment &env, const ArmLearnWrapper &wrapper) const;
+
+    /// When set, roots are evaluated by remote evaluation workers
+    ShardedEvaluator *shardedEvaluator = nullptr;
+
+    /// When set, roots are evaluated by forked processes
+    std::unique_ptr<ForkedEvaluator> forkedEvaluator;
+
+    /**
+    * \brief Evaluates all roots outside of this process.
+    *
+    * Roots whose evaluation is not skipped are given to evaluateRoots, which
+    * returns their average score over nbEpisodes episodes. Programs do not
+    * run in this process, so the archive is not updated during the evaluation.
+    */
+    std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *>
+    evaluateAllRootsOutOfProcess(Learn::LearningMode mode, uint64_t nbEpisodes,
+                                 const std::vector<size_t> &representatives,
+                                 const std::function<std::vector<double>(
+                                         const std::vector<const TPG::TPGVertex *> &)> &evaluateRoots);
+
+    /// Evaluates a root on the environment given at construction
+    double evaluateRootLocally(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t nbEpisodes,
+                               Learn::LearningMode mode);
+
+    /**
+    * \brief Runs a single episode of a root on the given environment.
+    *
+    * \return the score of the environment at the end of the episode.
+    */
+    double evaluateEpisode(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t episode,
+                           Learn::LearningMode mode, Learn::LearningEnvironment &le) const;
+
+    /// Number of episodes evaluating a root in deterministic mode
+    uint64_t getNbDeterministicEpisodes(const ArmLearnWrapper &wrapper) const;
+
+public:
+    /**
+    * \brief Constructor, see Learn::ParallelLearningAgent.
+    */
+    ArmLearningAgent(ArmLearnWrapper &le, const Instructions::Set &iSet, const Learn::LearningParameters &p);
+
+    /**
+    * \brief Runs a single episode of a root on an environment in deterministic mode.
+    *
+    * If tee is a MemoizingExecutionEngine and le an ArmLearnWrapper,
+    * remembered decisions are used.
+    *
+    * \param[in] maxNbActions the maximum number of actions of the episode.
+    * \return the score of the environment at the end of the episode.
+    */
+    static double runEpisode(TPG::TPGExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t episode,
+                             Learn::LearningMode mode, Learn::LearningEnvironment &le, uint64_t maxNbActions);
+
+    /**
+    * \brief Runs episodes of a root on the lanes of the engine.
+    *
+    * Episode firstEpisode + l runs on lane l, for nbEpisodes lanes at most
+    * LANE_WIDTH, and its score is written in scores[l].
+    */
+    static void runLaneEpisodes(LaneExecutionEngine &tee, const TPG::TPGVertex &root, uint64_t firstEpisode,
+                                size_t nbEpisodes, Learn::LearningMode mode, uint64_t maxNbActions, double *scores);
+
+    /**
+    * \brief Enables the parallel evaluation of the episodes of a root.
+    *
+    * Only effective when the ArmLearnWrapper is in deterministic mode, since
+    * episodes must be independent from each other to be run on separate
+    * clones, and when several threads are available.
+    */
+    void setIntraRootParallelism(bool enabled);
+
+    /// Selects how evaluation jobs are distributed on threads
+    void setEvaluationScheduler(EvaluationScheduler type);
+
+    /**
+    * \brief Statistics of each thread during the last evaluation of all roots.
+    *
+    * Empty if the last evaluation was done by the default gegelati loop.
+    */
+    std::vector<JobScheduler::WorkerStats> getWorkerStats() const;
+
+    /**
+    * \brief Sets the cpus on which evaluation threads are pinned.
+    *
+    * Each thread is pinned before creating its clone of the ArmLearnWrapper
+    * (with its simulator, converter and data handlers) and its execution
+    * engine, so that they are allocated on the NUMA node of the thread.
+    */
+    void setThreadPlacement(const ThreadPlacement &placement);
+
+    /**
+    * \brief Enables racing during training.
+    *
+    * The evaluation of a root stops as soon as its result can not reach the
+    * results of the roots surviving the decimation, given the results of the
+    * roots already evaluated. Its result is then the bound, with all its
+    * episodes counted. Only used in training mode, on deterministic
+    * ArmLearnWrapper evaluated in this process, and with root-level jobs.
+    *
+    * \param[in] confidence 1 to only stop roots that can not survive, or
+    * the probability for a stopped root not to survive.
+    */
+    void setRacing(bool enabled, double confidence = 1.0);
+
+    /// Number of episodes skipped by racing during the last evaluation of all roots
+    uint64_t getNbRacingCutEpisodes() const;
+
+    /**
+    * \brief Enables the memoization of decisions by evaluation threads.
+    *
+    * Each thread uses a MemoizingExecutionEngine created for the evaluation
+    * of all roots, so remembered decisions never survive a mutation of the
+    * graph. Scores are unchanged, but remembered decisions are not archived.
+    */
+    void setDecisionMemoization(bool enabled);
+
+    /**
+    * \brief Enables the incremental execution of programs by evaluation threads.
+    *
+    * Each thread uses an IncrementalExecutionEngine created for the
+    * evaluation of all roots. Scores are unchanged, but reused program
+    * results are not archived.
+    */
+    void setIncrementalExecution(bool enabled);
+
+    /**
+    * \brief Enables the compilation of long-lived programs, see ProgramJit.
+    *
+    * Before each evaluation of all roots, programs present in the graph for
+    * at least minAge generations are compiled. Evaluation threads then
+    * execute them natively, the other ones being interpreted. Scores are
+    * unchanged, but native executions are not archived.
+    */
+    void setJit(bool enabled, uint64_t minAge = 10, const std::string &compiler = "cc",
+                const std::string &directory = "/tmp");
+
+    /**
+    * \brief Enables the execution of a root on several arms at once.
+    *
+    * Each evaluation thread uses a LaneExecutionEngine, on which the
+    * episodes of a root run LANE_WIDTH at a time, each program being
+    * executed over all lanes together. Only used with a deterministic
+    * ArmLearnWrapper, and the episodes of a root are not dispatched on
+    * several threads. Scores are unchanged, but lane executions are not
+    * archived.
+    */
+    void setLaneExecution(bool enabled);
+
+    /// Number of programs of the graph executed natively during the last evaluation of all roots
+    size_t getNbCompiledPrograms() const;
+
+    /**
+    * \brief Enables behavioural deduplication during training.
+    *
+    * Before evaluating roots, each new root is executed on a fixed set of
+    * recorded observations (see ObservationProbe). Only one root per
+    * sequence of actions taken on these observations is evaluated, and its
+    * result is copied to the others.
+    */
+    void setDeduplication(bool enabled, uint64_t nbObservations = 64);
+
+    /// Fraction of the root evaluations saved by deduplication during the last evaluation of all roots
+    double getDeduplicationRatio() const;
+
+    /**
+    * \brief Evaluates roots with the given ShardedEvaluator, nullptr to evaluate them locally.
+    *
+    * Only effective when the ArmLearnWrapper is in deterministic mode, since
+    * workers replay episodes from their seed.
+    */
+    void setShardedEvaluator(ShardedEvaluator *evaluator);
+
+    /**
+    * \brief Enables the evaluation of roots in forked processes, see ForkedEvaluator.
+    *
+    * One process per thread is forked at each evaluation, pinned according to
+    * the thread placement. Only effective when the ArmLearnWrapper is in
+    * deterministic mode.
+    */
+    void setForkedEvaluation(bool enabled);
+
+    /**
+    * \brief Applies the evaluation options of the ArmLearnParameters.
+    *
+    * Sets intra-root parallelism, the scheduler, forked evaluation, racing,
+    * deduplication, cycle detection of the ArmLearnWrapper and, if threads
+    * are pinned, the thread placement.
+    */
+    void setParameters(const ArmLearnParameters &armParams);
+
+    /**
+    * \brief Evaluates the root of the job on the given LearningEnvironment.
+    *
+    * Falls back to the default gegelati evaluation if the environment is not
+    * a deterministic ArmLearnWrapper.
+    */
+    std::shared_ptr<Learn::EvaluationResult>
+    evaluateJob(TPG::TPGExecutionEngine &tee, const Learn::Job &job, uint64_t generationNumber,
+                Learn::LearningMode mode, Learn::LearningEnvironment &le) const override;
+
+    /**
+    * \brief Evaluates all roots of the TPGGraph.
+    *
+    * With intra-root parallelism, each (root, episode) pair is a job taken by
+    * the first idle worker, so that slow roots do not delay the end of the
+    * generation. Otherwise each root is a job. Jobs are run on per-thread
+    * clones of the ArmLearnWrapper, unless neither intra-root parallelism,
+    * work-stealing nor thread pinning is enabled, in which case the
+    * Learn::ParallelLearningAgent evaluation is used.
+    */
+    std::multimap<std::shared_ptr<Learn::EvaluationResult>, const TPG::TPGVertex *>
+    evaluateAllRoots(uint64_t generationNumber, Learn::LearningMode mode) override;
+};
+
+#endif //ARMGEGELATI_ARMLEARNINGAGENT_H
@@ -0,0 +1,110 @@
+#ifndef ARMGEGELATI_BYTESTREAM_H
+#define ARMGEGELATI_BYTESTREAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+/**
+* \brief Appends values to a byte buffer.
+*
+* Unsigned integers are written as variable-length integers (7 bits per
+* byte), doubles and raw values with their in-memory representation.
+*/
+class ByteWriter {
+protected:
+    std::vector<uint8_t> &buffer;
+
+public:
+    explicit ByteWriter(std::vector<uint8_t> &buffer) : buffer(buffer) {}
+
+    void writeVarUInt(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back((uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((uint8_t) value);
+    }
+
+    void writeDouble(double value) {
+        writeRaw(&value, sizeof(double));
+    }
+
+    void writeRaw(const void *data, size_t size) {
+        auto bytes = (const uint8_t *) data;
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+};
+
+/**
+* \brief Reads values written by a ByteWriter.
+*
+* Throws std::runtime_error when reading past the end of the buffer.
+*/
+class ByteReader {
+protected:
+    const uint8_t *data;
+
+    size_t size;
+
+    size_t position = 0;
+
+public:
+    ByteReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    uint64_t readVarUInt() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (position >= size) {
+                throw std::runtime_error("Unexpected end of byte stream.");
+            }
+            uint8_t byte = data[position++];
+            value |= (uint64_t) (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid variable-length integer.");
+    }
+
+    double readDouble() {
+        double value;
+        readRaw(&value, sizeof(double));
+        return value;
+    }
+
+    void readRaw(void *destination, size_t nbBytes) {
+        if (position + nbBytes > size) {
+            throw std::runtime_error("Unexpected end of byte stream.");
+        }
+        std::memcpy(destination, data + position, nbBytes);
+        position += nbBytes;
+    }
+
+    /**
+    * \brief Reads a number of items, each taking at least itemSize bytes of the stream.
+    *
+    * Throws std::runtime_error if the remaining bytes can not hold that many
+    * items, so that a corrupt count is detected before allocating the items.
+    */
+    uint64_t readCount(size_t itemSize) {
+        uint64_t count = readVarUInt();
+        if (count > getRemaining() / itemSize) {
+            throw std::runtime_error("Invalid number of items in byte stream.");
+        }
+        return count;
+    }
+
+    /// Returns the number of bytes left to read
+    size_t getRemaining() const {
+        return size - position;
+    }
+
+    /// Returns true if all bytes were read
+    bool atEnd() const {
+        return position == size;
+    }
+};
+
+#endif //ARMGEGELATI_BYTESTREAM_H
@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ArmLearningAgent.h"
+#include "ForkedEvaluation.h"
+
+ForkedEvaluator::ForkedEvaluator(size_t nbProcesses, const ThreadPlacement &placement) : nbProcesses(
+        std::max<size_t>(nbProcesses, 1)), placement(placement) {
+}
+
+size_t ForkedEvaluator::getNbProcesses() const {
+    return nbProcesses;
+}
+
+std::vector<double> ForkedEvaluator::evaluate(const std::vector<const TPG::TPGVertex *> &roots,
+                                              const ArmLearnWrapper &wrapper, const Environment &env,
+                                              Learn::LearningMode mode, uint64_t nbEpisodes,
+                                              uint64_t maxNbActions,
+                                              const std::function<double(const TPG::TPGVertex &)> &localEvaluation) const {
+    std::vector<double> scores(roots.size());
+    if (roots.empty()) {
+        return scores;
+    }
+
+    // Results written by the children, NaN until a root is evaluated
+    size_t mappingSize = roots.size() * sizeof(double);
+    void *mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map the results of forked evaluation, roots are evaluated locally." << std::endl;
+        for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+            scores[rootIdx] = localEvaluation(*roots[rootIdx]);
+        }
+        return scores;
+    }
+    auto sharedScores = (double *) mapping;
+    std::fill(sharedScores, sharedScores + roots.size(), std::numeric_limits<double>::quiet_NaN());
+
+    // Flush buffered output, otherwise children would print it again
+    std::cout.flush();
+    fflush(stdout);
+
+    size_t nbChildren = std::min(nbProcesses, roots.size());
+    std::vector<pid_t> children;
+    for (size_t processIdx = 0; processIdx < nbChildren; processIdx++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int exitCode = 0;
+            try {
+                // Pin the process before it allocates its data, so that it lands on its NUMA node
+                placement.pinCurrentThread(processIdx);
+
+                std::unique_ptr<Learn::LearningEnvironment> privateLe(wrapper.clone());
+                Environment privateEnv(env.getInstructionSet(), privateLe->getDataSources(), env.getNbRegisters());
+                // No archive is updated, decisions and program results can always be reused
+                IncrementalExecutionEngine tee(privateEnv, 1 << 16);
+
+                for (size_t rootIdx = processIdx; rootIdx < roots.size(); rootIdx += nbChildren) {
+                    double result = 0.0;
+                    for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+                        result += ArmLearningAgent::runEpisode(tee, *roots[rootIdx], episode, mode, *privateLe,
+                                                               maxNbActions);
+                    }
+                    sharedScores[rootIdx] = result / (double) nbEpisodes;
+                }
+            } catch (...) {
+                exitCode = 1;
+            }
+            // Leave without running destructors of the objects inherited from the parent
+            _exit(exitCode);
+        }
+        if (pid > 0) {
+            children.push_back(pid);
+        }
+    }
+
+    for (pid_t pid : children) {
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+    }
+
+    // Roots of failed or missing processes are evaluated here
+    for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+        scores[rootIdx] = std::isnan(sharedScores[rootIdx]) ? localEvaluation(*roots[rootIdx])
+                                                             : sharedScores[rootIdx];
+    }
+
+    munmap(mapping, mappingSize);
+    return scores;
+}
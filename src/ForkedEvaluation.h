@@ -0,0 +1,60 @@
+#ifndef ARMGEGELATI_FORKEDEVALUATION_H
+#define ARMGEGELATI_FORKEDEVALUATION_H
+
+#include <functional>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+#include "ThreadPlacement.h"
+
+/**
+* \brief Evaluation of roots in forked worker processes.
+*
+* Worker processes are forked at each evaluation, so they see the TPGGraph and
+* the instruction set of the parent through copy-on-write pages, without any
+* copy or serialization. Each process evaluates a fixed subset of the roots on
+* its own clone of the ArmLearnWrapper and writes the scores in a results
+* array shared with the parent. Processes share no allocator, no reference
+* counter and no atomic, so evaluation scales with cores even where threads
+* contend on the shared pointers created by the environment and gegelati.
+*
+* The parent must not run other threads while evaluating, since only the
+* forking thread exists in the children.
+*/
+class ForkedEvaluator {
+protected:
+    size_t nbProcesses;
+
+    /// Cpus of the worker processes
+    ThreadPlacement placement;
+
+public:
+    /**
+    * \brief Constructor.
+    *
+    * \param[in] nbProcesses number of worker processes forked at each evaluation.
+    * \param[in] placement cpus on which worker processes are pinned.
+    */
+    ForkedEvaluator(size_t nbProcesses, const ThreadPlacement &placement = ThreadPlacement());
+
+    size_t getNbProcesses() const;
+
+    /**
+    * \brief Evaluates roots in forked processes.
+    *
+    * Process w evaluates roots w, w + nbProcesses, ... Roots of processes that
+    * fail are evaluated in the calling process with localEvaluation.
+    *
+    * \param[in] wrapper environment cloned by each process, in deterministic mode.
+    * \param[in] env Environment whose instruction set and registers are used.
+    * \return the average score of each root over nbEpisodes episodes.
+    */
+    std::vector<double> evaluate(const std::vector<const TPG::TPGVertex *> &roots, const ArmLearnWrapper &wrapper,
+                                 const Environment &env, Learn::LearningMode mode, uint64_t nbEpisodes,
+                                 uint64_t maxNbActions,
+                                 const std::function<double(const TPG::TPGVertex &)> &localEvaluation) const;
+};
+
+#endif //ARMGEGELATI_FORKEDEVALUATION_H
@@ -0,0 +1,66 @@
+#include "IncrementalExecutionEngine.h"
+
+IncrementalExecutionEngine::IncrementalExecutionEngine(const Environment &env, size_t maxNbDecisions,
+                                                       Archive *archive)
+        : MemoizingExecutionEngine(env, maxNbDecisions, archive) {
+}
+
+uint16_t IncrementalExecutionEngine::getInputMask(const Program::Program &program) {
+    auto found = inputMasks.find(&program);
+    if (found != inputMasks.end()) {
+        return found->second;
+    }
+
+    const Environment &env = program.getEnvironment();
+    const auto &dataSources = env.getDataSources();
+    uint16_t mask = 0;
+    for (uint64_t lineIdx = 0; lineIdx < program.getNbLines(); lineIdx++) {
+        const Program::Line &line = program.getLine(lineIdx);
+        for (uint64_t i = 0; i < env.getMaxNbOperands(); i++) {
+            const auto &operand = line.getOperand(i);
+            // source 0 is the registers, then the sources of the ArmLearnWrapper: cartesianDif and motorPos
+            if (operand.first == 0) {
+                continue;
+            }
+            uint64_t addressSpace = dataSources.at(operand.first - 1).get().getAddressSpace(typeid(double));
+            uint64_t location = operand.second % addressSpace;
+            mask |= (uint16_t) (1 << ((operand.first == 1) ? location : 3 + location));
+        }
+    }
+
+    inputMasks.emplace(&program, mask);
+    return mask;
+}
+
+double IncrementalExecutionEngine::evaluateEdge(const TPG::TPGEdge &edge) {
+    if (observedWrapper == nullptr) {
+        nbExecutedPrograms++;
+        return MemoizingExecutionEngine::evaluateEdge(edge);
+    }
+
+    uint16_t mask = getInputMask(edge.getProgram());
+    auto cached = edgeResults.find(&edge);
+    if (cached != edgeResults.end() && observedWrapper->getLastInputChange(mask) <= cached->second.version) {
+        nbReusedResults++;
+        return cached->second.result;
+    }
+
+    nbExecutedPrograms++;
+    double result = MemoizingExecutionEngine::evaluateEdge(edge);
+    edgeResults[&edge] = {result, observedWrapper->getInputVersion()};
+    return result;
+}
+
+void IncrementalExecutionEngine::clearDecisions() {
+    MemoizingExecutionEngine::clearDecisions();
+    edgeResults.clear();
+    inputMasks.clear();
+}
+
+uint64_t IncrementalExecutionEngine::getNbReusedResults() const {
+    return nbReusedResults;
+}
+
+uint64_t IncrementalExecutionEngine::getNbExecutedPrograms() const {
+    return nbExecutedPrograms;
+}
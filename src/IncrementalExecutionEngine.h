@@ -0,0 +1,65 @@
+#ifndef ARMGEGELATI_INCREMENTALEXECUTIONENGINE_H
+#define ARMGEGELATI_INCREMENTALEXECUTIONENGINE_H
+
+#include <unordered_map>
+
+#include <gegelati.h>
+
+#include "MemoizingExecutionEngine.h"
+
+/**
+* \brief Execution engine re-executing programs only when their inputs changed.
+*
+* The inputs read by each program are found by a static analysis of its
+* operands: all lines are considered, including introns, so the set is an
+* over-approximation. Registers are reset before each execution, so the
+* result of a program only depends on these inputs.
+*
+* An action of the ArmLearnWrapper moves a single joint, changing one
+* motorPos value and the cartesianDif values, so programs reading other
+* inputs keep their previous result. Results are kept per edge, with the
+* input version of the ArmLearnWrapper at which they were computed.
+*
+* Results are only reused during executeDecision(), which gives the observed
+* ArmLearnWrapper. As with decisions, reused results are not archived, and
+* an engine must not outlive the generation in which it is created.
+*/
+class IncrementalExecutionEngine : public MemoizingExecutionEngine {
+protected:
+    struct EdgeResult {
+        double result;
+        /// Input version of the wrapper when the result was computed
+        uint64_t version;
+    };
+
+    std::unordered_map<const TPG::TPGEdge *, EdgeResult> edgeResults;
+
+    /// Inputs read by each program, bit i for value i of ArmLearnWrapper::getObservation()
+    std::unordered_map<const Program::Program *, uint16_t> inputMasks;
+
+    uint64_t nbReusedResults = 0;
+
+    uint64_t nbExecutedPrograms = 0;
+
+    /// Returns the inputs read by the program
+    uint16_t getInputMask(const Program::Program &program);
+
+public:
+    /// Constructor, see MemoizingExecutionEngine
+    explicit IncrementalExecutionEngine(const Environment &env, size_t maxNbDecisions = 0,
+                                        Archive *archive = NULL);
+
+    /// Returns the cached result of the program of the edge if its inputs did not change
+    double evaluateEdge(const TPG::TPGEdge &edge) override;
+
+    /// Forgets decisions, program results and analyses
+    void clearDecisions() override;
+
+    /// Number of program results reused without execution
+    uint64_t getNbReusedResults() const;
+
+    /// Number of executed programs
+    uint64_t getNbExecutedPrograms() const;
+};
+
+#endif //ARMGEGELATI_INCREMENTALEXECUTIONENGINE_H
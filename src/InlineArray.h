@@ -0,0 +1,93 @@
+#ifndef ARMGEGELATI_INLINEARRAY_H
+#define ARMGEGELATI_INLINEARRAY_H
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include <gegelati.h>
+
+/**
+* \brief DataHandler of N doubles stored in the handler itself.
+*
+* Same behaviour as a Data::PrimitiveTypeArray<double> of N values, but the
+* values are a member instead of a heap buffer, so they are wherever the
+* handler is, e.g. in the EpisodeState of an ArmLearnWrapper.
+*/
+template<size_t N>
+class InlineArray : public Data::DataHandler {
+protected:
+    double values[N] = {0};
+
+    /// Inherited via DataHandler, combines the id of the handler with its values
+    size_t updateHash() const override {
+        this->cachedHash = std::hash<size_t>()(this->id);
+        for (double value : values) {
+            size_t hash = std::hash<double>()(value);
+            this->cachedHash ^= hash + 0x9e3779b9 + (this->cachedHash << 6) + (this->cachedHash >> 2);
+        }
+        this->invalidCachedHash = false;
+        return this->cachedHash;
+    }
+
+public:
+    InlineArray() {
+        this->providedTypes.push_back(typeid(double));
+    }
+
+    InlineArray(const InlineArray &other) = default;
+
+    /// Inherited via DataHandler
+    Data::DataHandler *clone() const override {
+        return new InlineArray(*this);
+    }
+
+    /// Values of the handler, read without creating shared pointers
+    const double *getValues() const {
+        return values;
+    }
+
+    void setDataAt(const std::type_info &type, size_t address, double value) {
+#ifndef NDEBUG
+        if (type != typeid(double) || address >= N) {
+            throw std::invalid_argument("Invalid type or address for an InlineArray.");
+        }
+#endif
+        values[address] = value;
+        this->invalidCachedHash = true;
+    }
+
+    /// Inherited via DataHandler
+    size_t getAddressSpace(const std::type_info &type) const override {
+        return (type == typeid(double)) ? N : 0;
+    }
+
+    /// Inherited via DataHandler
+    size_t getLargestAddressSpace() const override {
+        return N;
+    }
+
+    /// Inherited via DataHandler
+    void resetData() override {
+        std::fill(values, values + N, 0.0);
+        this->invalidCachedHash = true;
+    }
+
+    /// Inherited via DataHandler, the pointer does not own the value
+    const Data::UntypedSharedPtr getDataAt(const std::type_info &type, size_t address) const override {
+#ifndef NDEBUG
+        if (type != typeid(double) || address >= N) {
+            throw std::invalid_argument("Invalid type or address for an InlineArray.");
+        }
+#endif
+        return Data::UntypedSharedPtr(&values[address], Data::UntypedSharedPtr::emptyDestructor<const double>());
+    }
+
+    /// Inherited via DataHandler
+    std::vector<size_t> getAddressesAccessed(const std::type_info &, size_t address) const override {
+        return {address};
+    }
+};
+
+#endif //ARMGEGELATI_INLINEARRAY_H
@@ -0,0 +1,146 @@
+#include <cinttypes>
+#include <iostream>
+#include <thread>
+
+#include "IslandModel.h"
+
+// Number of random goals of a generation
+#define NB_GOALS_PER_GENERATION 10
+
+void MigrationQueue::push(PolicyGraph policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policies.push_back(std::move(policy));
+}
+
+std::vector<PolicyGraph> MigrationQueue::popAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<PolicyGraph> result(policies.begin(), policies.end());
+    policies.clear();
+    return result;
+}
+
+IslandModel::IslandModel(const Instructions::Set &set, const Learn::LearningParameters &params,
+                         const ArmLearnParameters &armParams) : migrationPeriod(armParams.migrationPeriod) {
+    size_t nbIslands = std::max<uint64_t>(armParams.nbIslands, 1);
+
+    // cpus ordered by NUMA node, so that contiguous subsets stay on a node when possible
+    ThreadPlacement allCpus(armParams.cpus, armParams.scatterThreads);
+    // subsets of cpus are only disjoint if each island has at least one
+    bool pinIslands = armParams.pinThreads && allCpus.getNbCpus() >= nbIslands;
+    if (armParams.pinThreads && !pinIslands) {
+        std::cerr << "Only " << allCpus.getNbCpus() << " cpus for " << nbIslands
+                  << " islands, island threads are not pinned." << std::endl;
+    }
+    size_t nbCpus = std::max<size_t>(allCpus.getNbCpus(), nbIslands);
+
+    for (size_t islandIdx = 0; islandIdx < nbIslands; islandIdx++) {
+        size_t firstCpu = islandIdx * nbCpus / nbIslands;
+        size_t lastCpu = (islandIdx + 1) * nbCpus / nbIslands;
+
+        Learn::LearningParameters islandParams = params;
+        islandParams.nbThreads = lastCpu - firstCpu;
+        islandParams.mutation.tpg.nbRoots = std::max<size_t>(params.mutation.tpg.nbRoots / nbIslands, 1);
+
+        auto island = std::unique_ptr<Island>(new Island());
+        island->le.reset(new ArmLearnWrapper(&island->gen));
+        island->le->setDeterministicEvaluation(armParams.deterministicEvaluation);
+        // each island has its own goal stream
+        island->le->setRandomSeed(islandIdx);
+
+        island->la.reset(new ArmLearningAgent(*island->le, set, islandParams));
+        island->la->setParameters(armParams);
+        // islands train on concurrent threads, which forked processes would not inherit
+        island->la->setForkedEvaluation(false);
+        if (pinIslands) {
+            std::vector<int> cpus;
+            for (size_t cpu = firstCpu; cpu < lastCpu; cpu++) {
+                cpus.push_back(allCpus.getCpu(cpu));
+            }
+            island->la->setThreadPlacement(ThreadPlacement(cpus, armParams.scatterThreads));
+        }
+        island->la->init(islandIdx);
+
+        islands.push_back(std::move(island));
+    }
+}
+
+IslandModel::~IslandModel() {
+    for (auto &island : islands) {
+        for (auto target : island->le->targets) {
+            delete target;
+        }
+    }
+}
+
+void IslandModel::trainIsland(size_t islandIdx, uint64_t nbGenerations) {
+    Island &island = *islands[islandIdx];
+    MigrationQueue &neighbourInbox = islands[(islandIdx + 1) % islands.size()]->inbox;
+
+    for (uint64_t generation = 0; generation < nbGenerations; generation++) {
+        island.gen = (int) generation;
+        for (auto target : island.le->targets) {
+            delete target;
+        }
+        island.le->targets.clear();
+        for (int j = 0; j < NB_GOALS_PER_GENERATION; j++) {
+            island.le->targets.emplace_back(island.le->randomGoal());
+        }
+
+        island.la->trainOneGeneration(generation);
+
+        if (islands.size() > 1 && migrationPeriod > 0 && (generation + 1) % migrationPeriod == 0) {
+            const TPG::TPGVertex *best = island.la->getBestRoot().first;
+            if (best != nullptr) {
+                neighbourInbox.push(PolicyGraph::extract(*best));
+            }
+            for (auto &migrant : island.inbox.popAll()) {
+                migrant.insertInto(island.la->getTPGGraph());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(logMutex);
+        auto best = island.la->getBestRoot();
+        printf("%3zu\t%3" PRIu64 "\t%4" PRIu64 "\t%1.2lf\n", islandIdx, generation,
+               island.la->getTPGGraph().getNbVertices(),
+               (best.second != nullptr) ? best.second->getResult() : 0.0);
+    }
+}
+
+void IslandModel::train(uint64_t nbGenerations) {
+    printf("\nIsland\tGen\tNbVert\tBest\n");
+
+    std::vector<std::thread> threads;
+    for (size_t islandIdx = 0; islandIdx < islands.size(); islandIdx++) {
+        threads.emplace_back(&IslandModel::trainIsland, this, islandIdx, nbGenerations);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+ArmLearningAgent &IslandModel::getBestIsland() {
+    return *islands[getBestIslandIdx()]->la;
+}
+
+ArmLearnWrapper &IslandModel::getWrapper(size_t islandIdx) {
+    return *islands.at(islandIdx)->le;
+}
+
+void IslandModel::setRecorder(TrajectoryRecorder *recorder) {
+    for (auto &island : islands) {
+        island->le->setRecorder(recorder);
+    }
+}
+
+size_t IslandModel::getBestIslandIdx() const {
+    size_t bestIsland = 0;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    for (size_t islandIdx = 0; islandIdx < islands.size(); islandIdx++) {
+        auto best = islands[islandIdx]->la->getBestRoot();
+        if (best.second != nullptr && best.second->getResult() > bestScore) {
+            bestScore = best.second->getResult();
+            bestIsland = islandIdx;
+        }
+    }
+    return bestIsland;
+}
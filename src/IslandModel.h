@@ -0,0 +1,93 @@
+#ifndef ARMGEGELATI_ISLANDMODEL_H
+#define ARMGEGELATI_ISLANDMODEL_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+#include "ArmLearningAgent.h"
+#include "ArmLearnParameters.h"
+#include "PolicyGraph.h"
+
+/**
+* \brief Thread-safe queue of policies sent to an island.
+*/
+class MigrationQueue {
+protected:
+    std::mutex mutex;
+
+    std::deque<PolicyGraph> policies;
+
+public:
+    /// Adds a policy at the end of the queue
+    void push(PolicyGraph policy);
+
+    /// Removes and returns all policies of the queue
+    std::vector<PolicyGraph> popAll();
+};
+
+/**
+* \brief Island model training several populations in parallel.
+*
+* Each island has its own ArmLearnWrapper, with its own stream of random
+* goals, and its own ArmLearningAgent whose threads can be pinned on a
+* disjoint subset of the cpus. Islands train independently, without synchronization between
+* their generations. Every migrationPeriod generations, each island sends a
+* copy of its best root to the next island (in a ring) and inserts the roots it
+* received as new roots of its TPGGraph.
+*/
+class IslandModel {
+protected:
+    struct Island {
+        std::unique_ptr<ArmLearnWrapper> le;
+        std::unique_ptr<ArmLearningAgent> la;
+        MigrationQueue inbox;
+        int gen = 0;
+    };
+
+    std::vector<std::unique_ptr<Island>> islands;
+
+    uint64_t migrationPeriod;
+
+    /// Protects std::cout between islands
+    std::mutex logMutex;
+
+    /// Training loop of an island
+    void trainIsland(size_t islandIdx, uint64_t nbGenerations);
+
+public:
+    /**
+    * \brief Creates armParams.nbIslands islands.
+    *
+    * The roots and threads of params are split between islands. If
+    * armParams.pinThreads is set, each island is pinned on its own contiguous
+    * subset of the cpus, ordered by NUMA node. With fewer cpus than islands,
+    * subsets can not be disjoint, so a warning is printed and islands are
+    * not pinned.
+    */
+    IslandModel(const Instructions::Set &set, const Learn::LearningParameters &params,
+                const ArmLearnParameters &armParams);
+
+    /// Destructor, deletes the goals of the islands
+    ~IslandModel();
+
+    /// Trains all islands in parallel for nbGenerations generations
+    void train(uint64_t nbGenerations);
+
+    /// Returns the agent of the island owning the best root
+    ArmLearningAgent &getBestIsland();
+
+    /// Returns the index of the island owning the best root
+    size_t getBestIslandIdx() const;
+
+    /// Returns the environment of an island
+    ArmLearnWrapper &getWrapper(size_t islandIdx);
+
+    /// Records the episodes of all islands, see ArmLearnWrapper::setRecorder()
+    void setRecorder(TrajectoryRecorder *recorder);
+};
+
+#endif //ARMGEGELATI_ISLANDMODEL_H
@@ -0,0 +1,146 @@
+#include "JobScheduler.h"
+
+JobScheduler::JobScheduler(size_t nbWorkers) : workers(nbWorkers) {
+}
+
+size_t JobScheduler::getNbWorkers() const {
+    return workers.size();
+}
+
+void JobScheduler::start(size_t nbJobs) {
+    for (auto &worker : workers) {
+        worker.stats = WorkerStats();
+        worker.busy = false;
+    }
+    distributeJobs(nbJobs);
+    runStart = std::chrono::steady_clock::now();
+}
+
+bool JobScheduler::nextJob(size_t workerIdx, size_t &jobIdx) {
+    WorkerState &worker = workers[workerIdx];
+    if (worker.busy) {
+        worker.stats.busyTime += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - worker.jobStart).count();
+        worker.busy = false;
+    }
+
+    bool stolen = false;
+    if (!fetchJob(workerIdx, jobIdx, stolen)) {
+        return false;
+    }
+
+    worker.stats.nbJobs++;
+    if (stolen) {
+        worker.stats.nbStolenJobs++;
+    }
+    worker.busy = true;
+    worker.jobStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+void JobScheduler::stop() {
+    double runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    for (auto &worker : workers) {
+        worker.stats.idleTime = std::max(0.0, runTime - worker.stats.busyTime);
+    }
+}
+
+std::vector<JobScheduler::WorkerStats> JobScheduler::getWorkerStats() const {
+    std::vector<WorkerStats> stats;
+    for (auto &worker : workers) {
+        stats.push_back(worker.stats);
+    }
+    return stats;
+}
+
+SharedCounterScheduler::SharedCounterScheduler(size_t nbWorkers) : JobScheduler(nbWorkers) {
+}
+
+void SharedCounterScheduler::distributeJobs(size_t nbJobs) {
+    this->nbJobs = nbJobs;
+    nextJobIdx = 0;
+}
+
+bool SharedCounterScheduler::fetchJob(size_t, size_t &jobIdx, bool &stolen) {
+    // jobs are not assigned to workers, none is stolen
+    stolen = false;
+    jobIdx = nextJobIdx.fetch_add(1);
+    return jobIdx < nbJobs;
+}
+
+WorkStealingScheduler::WorkStealingScheduler(size_t nbWorkers) : JobScheduler(nbWorkers), queues(nbWorkers) {
+}
+
+void WorkStealingScheduler::distributeJobs(size_t nbJobs) {
+    size_t nbWorkers = queues.size();
+    for (size_t workerIdx = 0; workerIdx < nbWorkers; workerIdx++) {
+        // contiguous blocks keep the episodes of a root on the same worker
+        size_t first = workerIdx * nbJobs / nbWorkers;
+        size_t last = (workerIdx + 1) * nbJobs / nbWorkers;
+
+        std::lock_guard<std::mutex> lock(queues[workerIdx].mutex);
+        queues[workerIdx].jobs.clear();
+        for (size_t jobIdx = first; jobIdx < last; jobIdx++) {
+            queues[workerIdx].jobs.push_back(jobIdx);
+        }
+        queues[workerIdx].victimSeed = workerIdx + 1;
+    }
+}
+
+bool WorkStealingScheduler::steal(size_t workerIdx, size_t victimIdx) {
+    JobQueue &victim = queues[victimIdx];
+    JobQueue &thief = queues[workerIdx];
+
+    // Locks are taken one at a time, so that two workers stealing from each other cannot deadlock
+    std::deque<size_t> loot;
+    {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        size_t nbStolen = (victim.jobs.size() + 1) / 2;
+        for (size_t i = 0; i < nbStolen; i++) {
+            loot.push_front(victim.jobs.back());
+            victim.jobs.pop_back();
+        }
+    }
+    if (loot.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(thief.mutex);
+    thief.jobs.insert(thief.jobs.end(), loot.begin(), loot.end());
+    return true;
+}
+
+bool WorkStealingScheduler::fetchJob(size_t workerIdx, size_t &jobIdx, bool &stolen) {
+    JobQueue &own = queues[workerIdx];
+    size_t nbWorkers = queues.size();
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                jobIdx = own.jobs.front();
+                own.jobs.pop_front();
+                return true;
+            }
+        }
+
+        // Visit all other workers, starting from a random one to spread the thieves
+        own.victimSeed ^= own.victimSeed << 13;
+        own.victimSeed ^= own.victimSeed >> 7;
+        own.victimSeed ^= own.victimSeed << 17;
+        size_t firstVictim = own.victimSeed % nbWorkers;
+
+        bool found = false;
+        for (size_t i = 0; i < nbWorkers && !found; i++) {
+            size_t victimIdx = (firstVictim + i) % nbWorkers;
+            if (victimIdx != workerIdx) {
+                found = steal(workerIdx, victimIdx);
+            }
+        }
+        if (!found) {
+            // no job is added during a run, all jobs are given
+            return false;
+        }
+        stolen = true;
+    }
+}
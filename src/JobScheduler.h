@@ -0,0 +1,127 @@
+#ifndef ARMGEGELATI_JOBSCHEDULER_H
+#define ARMGEGELATI_JOBSCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+* \brief Distributes evaluation jobs, identified by their index, to workers.
+*
+* A run is started with start(), then each worker repeatedly calls nextJob()
+* until it returns false, and the run is closed with stop(). The time spent by
+* each worker on jobs (busy) and waiting for or looking for jobs (idle) is
+* measured for each run.
+*/
+class JobScheduler {
+public:
+    /// Statistics of a worker for the last run
+    struct WorkerStats {
+        /// Time spent processing jobs, in seconds
+        double busyTime = 0.0;
+        /// Time of the run not spent processing jobs, in seconds
+        double idleTime = 0.0;
+        /// Number of jobs processed
+        uint64_t nbJobs = 0;
+        /// Number of jobs taken from other workers
+        uint64_t nbStolenJobs = 0;
+    };
+
+protected:
+    /// Per-worker state, on its own cache line to avoid false sharing between workers
+    struct alignas(64) WorkerState {
+        WorkerStats stats;
+        std::chrono::steady_clock::time_point jobStart;
+        bool busy = false;
+    };
+
+    std::vector<WorkerState> workers;
+
+    std::chrono::steady_clock::time_point runStart;
+
+    /// Prepares the distribution of jobs [0, nbJobs)
+    virtual void distributeJobs(size_t nbJobs) = 0;
+
+    /**
+    * \brief Takes a job for the worker.
+    *
+    * \param[out] stolen set to true if the job was initially assigned to another worker.
+    * \return false if no job remains.
+    */
+    virtual bool fetchJob(size_t workerIdx, size_t &jobIdx, bool &stolen) = 0;
+
+public:
+    explicit JobScheduler(size_t nbWorkers);
+
+    virtual ~JobScheduler() = default;
+
+    size_t getNbWorkers() const;
+
+    /// Starts a run over jobs [0, nbJobs)
+    void start(size_t nbJobs);
+
+    /**
+    * \brief Gives the next job of a worker, ending the previous one.
+    *
+    * \return false once all jobs were given, the worker may then stop.
+    */
+    bool nextJob(size_t workerIdx, size_t &jobIdx);
+
+    /// Ends the run, after all workers finished
+    void stop();
+
+    /// Statistics of each worker for the last run
+    std::vector<WorkerStats> getWorkerStats() const;
+};
+
+/**
+* \brief Parallel loop over jobs, each idle worker takes the next job of a shared counter.
+*/
+class SharedCounterScheduler : public JobScheduler {
+protected:
+    std::atomic<size_t> nextJobIdx{0};
+
+    size_t nbJobs = 0;
+
+    void distributeJobs(size_t nbJobs) override;
+
+    bool fetchJob(size_t workerIdx, size_t &jobIdx, bool &stolen) override;
+
+public:
+    explicit SharedCounterScheduler(size_t nbWorkers);
+};
+
+/**
+* \brief Work-stealing distribution of jobs.
+*
+* Jobs are split in contiguous blocks, one per worker, kept in per-worker
+* deques. A worker takes jobs from the front of its own deque and, once it is
+* empty, steals half of the remaining jobs from the back of the deque of
+* another worker. Since no job is added during a run, a worker stops when all
+* deques are empty.
+*/
+class WorkStealingScheduler : public JobScheduler {
+protected:
+    struct alignas(64) JobQueue {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+        /// State of the random victim selection of the owner
+        uint64_t victimSeed = 0;
+    };
+
+    std::vector<JobQueue> queues;
+
+    void distributeJobs(size_t nbJobs) override;
+
+    bool fetchJob(size_t workerIdx, size_t &jobIdx, bool &stolen) override;
+
+    /// Moves half of the jobs of a victim in the queue of the worker
+    bool steal(size_t workerIdx, size_t victimIdx);
+
+public:
+    explicit WorkStealingScheduler(size_t nbWorkers);
+};
+
+#endif //ARMGEGELATI_JOBSCHEDULER_H
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "ArmInstructions.h"
+#include "LaneExecutionEngine.h"
+#include "PolicyGraph.h"
+
+LaneExecutionEngine::LaneExecutionEngine(const Environment &env, const ArmLearnWrapper &wrapper, Archive *archive)
+        : TPGExecutionEngine(env, archive), environment(env),
+          rows((env.getNbRegisters() + ARM_OBSERVATION_SIZE) * LANE_WIDTH, 0.0), batch(wrapper) {
+}
+
+uint32_t LaneExecutionEngine::getVisitedLanes(const TPG::TPGVertex *team) const {
+    for (const auto &visited : visitedTeams) {
+        if (visited.first == team) {
+            return visited.second;
+        }
+    }
+    return 0;
+}
+
+ArmLearnWrapperBatch &LaneExecutionEngine::getBatch() {
+    return batch;
+}
+
+const std::vector<LaneExecutionEngine::LaneLine> &LaneExecutionEngine::decode(const Program::Program &program) {
+    auto found = decodedPrograms.find(&program);
+    if (found != decodedPrograms.end()) {
+        return found->second;
+    }
+
+    // Operand locations are already reduced modulo their address space
+    PolicyGraph::ProgramCopy compacted = PolicyGraph::compactProgram(PolicyGraph::copyProgram(program),
+                                                                     environment);
+    uint64_t nbRegisters = environment.getNbRegisters();
+    std::vector<LaneLine> lines;
+    for (const PolicyGraph::LineCopy &line : compacted.lines) {
+        if (line.instruction >= NB_ARM_INSTRUCTIONS) {
+            throw std::runtime_error("Instruction " + std::to_string(line.instruction) + " can not run on lanes.");
+        }
+        LaneLine laneLine{line.instruction, line.destination, {0, 0, 0}};
+        for (size_t i = 0; i < 3 && i < line.operands.size(); i++) {
+            const auto &operand = line.operands[i];
+            // source 0 is the registers, then cartesianDif and motorPos, stored after the registers
+            if (operand.first == 0) {
+                laneLine.operands[i] = operand.second;
+            } else {
+                laneLine.operands[i] = nbRegisters + ((operand.first == 1) ? operand.second : 3 + operand.second);
+            }
+        }
+        lines.push_back(laneLine);
+    }
+    return decodedPrograms.emplace(&program, std::move(lines)).first->second;
+}
+
+void LaneExecutionEngine::executeProgram(const std::vector<LaneLine> &lines, double *result) {
+    // registers are reset before each program, as by Program::ProgramExecutionEngine
+    std::fill(rows.begin(), rows.begin() + environment.getNbRegisters() * LANE_WIDTH, 0.0);
+    double *data = rows.data();
+
+    for (const LaneLine &line : lines) {
+        double *d = data + line.destination * LANE_WIDTH;
+        const double *a = data + line.operands[0] * LANE_WIDTH;
+        const double *b = data + line.operands[1] * LANE_WIDTH;
+        const double *c = data + line.operands[2] * LANE_WIDTH;
+        switch (line.instruction) {
+            case ARM_MINUS:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = a[l] - b[l];
+                break;
+            case ARM_ADD:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = a[l] + b[l];
+                break;
+            case ARM_TIMES:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = a[l] * b[l];
+                break;
+            case ARM_DIVIDE:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = a[l] / b[l];
+                break;
+            case ARM_COND:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = (a[l] < b[l]) ? -a[l] : a[l];
+                break;
+            case ARM_COS:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = std::cos(a[l]);
+                break;
+            case ARM_SIN:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = std::sin(a[l]);
+                break;
+            case ARM_HYPOT3:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = std::sqrt(a[l] * a[l] + b[l] * b[l] + c[l] * c[l]);
+                break;
+            case ARM_ATAN2:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = std::atan2(a[l], b[l]);
+                break;
+            case ARM_CLAMP:
+                for (size_t l = 0; l < LANE_WIDTH; l++) {
+                    d[l] = std::fmin(std::fmax(a[l], -std::fabs(b[l])), std::fabs(b[l]));
+                }
+                break;
+            case ARM_SERVO_TO_RADIAN:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = (a[l] - SERVO_CENTER) * SERVO_TO_RADIAN;
+                break;
+            case ARM_SIGN:
+                for (size_t l = 0; l < LANE_WIDTH; l++) d[l] = (double) ((a[l] > 0) - (a[l] < 0));
+                break;
+        }
+    }
+
+    for (size_t l = 0; l < LANE_WIDTH; l++) {
+        result[l] = std::isnan(data[l]) ? -std::numeric_limits<double>::infinity() : data[l];
+    }
+}
+
+void LaneExecutionEngine::executeFromRoot(const TPG::TPGVertex &root, const double *observations, uint32_t lanes,
+                                          uint64_t *actions) {
+    std::copy(observations, observations + ARM_OBSERVATION_SIZE * LANE_WIDTH,
+              rows.begin() + environment.getNbRegisters() * LANE_WIDTH);
+
+    const TPG::TPGVertex *current[LANE_WIDTH];
+    // keeps its capacity from one decision to the next
+    visitedTeams.clear();
+    for (size_t l = 0; l < LANE_WIDTH; l++) {
+        current[l] = &root;
+    }
+
+    uint32_t pending = lanes & ((1u << LANE_WIDTH) - 1);
+    while (pending != 0) {
+        // Group of the pending lanes on the vertex of the first one
+        size_t first = 0;
+        while (((pending >> first) & 1) == 0) {
+            first++;
+        }
+        const TPG::TPGVertex *vertex = current[first];
+        uint32_t group = 0;
+        for (size_t l = first; l < LANE_WIDTH; l++) {
+            if (((pending >> l) & 1) != 0 && current[l] == vertex) {
+                group |= 1u << l;
+            }
+        }
+        pending &= ~group;
+
+        auto action = dynamic_cast<const TPG::TPGAction *>(vertex);
+        if (action != nullptr) {
+            for (size_t l = 0; l < LANE_WIDTH; l++) {
+                if (((group >> l) & 1) != 0) {
+                    actions[l] = action->getActionID();
+                }
+            }
+            continue;
+        }
+
+        // The group can not have visited this team yet, other lanes may have
+        auto visited = std::find_if(visitedTeams.begin(), visitedTeams.end(),
+                                    [vertex](const std::pair<const TPG::TPGVertex *, uint32_t> &team) {
+                                        return team.first == vertex;
+                                    });
+        if (visited == visitedTeams.end()) {
+            visitedTeams.emplace_back(vertex, group);
+        } else {
+            visited->second |= group;
+        }
+
+        double bestBids[LANE_WIDTH];
+        const TPG::TPGEdge *bestEdges[LANE_WIDTH];
+        for (size_t l = 0; l < LANE_WIDTH; l++) {
+            bestBids[l] = -std::numeric_limits<double>::infinity();
+            bestEdges[l] = nullptr;
+        }
+
+        double bids[LANE_WIDTH];
+        for (const TPG::TPGEdge *edge : vertex->getOutgoingEdges()) {
+            // Lanes for which the edge leads to an already visited team are masked
+            uint32_t masked = group & ~getVisitedLanes(edge->getDestination());
+            if (masked == 0) {
+                continue;
+            }
+
+            executeProgram(decode(edge->getProgram()), bids);
+            for (size_t l = 0; l < LANE_WIDTH; l++) {
+                if (((masked >> l) & 1) != 0 && bids[l] >= bestBids[l]) {
+                    bestBids[l] = bids[l];
+                    bestEdges[l] = edge;
+                }
+            }
+        }
+
+        for (size_t l = 0; l < LANE_WIDTH; l++) {
+            if (((group >> l) & 1) == 0) {
+                continue;
+            }
+            if (bestEdges[l] == nullptr) {
+                // no edge to follow, as in generatePolicyC()
+                actions[l] = 0;
+            } else {
+                current[l] = bestEdges[l]->getDestination();
+                pending |= 1u << l;
+            }
+        }
+    }
+}
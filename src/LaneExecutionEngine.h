@@ -0,0 +1,89 @@
+#ifndef ARMGEGELATI_LANEEXECUTIONENGINE_H
+#define ARMGEGELATI_LANEEXECUTIONENGINE_H
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapperBatch.h"
+
+/**
+* \brief Execution engine running a root on the LANE_WIDTH arms of an ArmLearnWrapperBatch at once.
+*
+* Programs are interpreted line by line over all lanes: each register is a
+* row of LANE_WIDTH values, each operand reads a register row or an
+* observation row of ArmLearnWrapperBatch::copyObservations(), and each
+* instruction is a loop over the lanes that the compiler vectorizes.
+* Programs are decoded once, without their introns (see
+* PolicyGraph::compactProgram()).
+*
+* Lanes may take different edges of a team. The graph is walked by groups of
+* lanes on the same team: the programs of the team run over all lanes, and
+* only the lanes of the group, given by a mask, use the results. Lanes leading
+* to a team they already visited skip its edge, as in
+* TPG::TPGExecutionEngine, so each lane takes the decision it would take
+* alone.
+*
+* Instructions are identified by their index in the instruction set, which
+* must be the one of armGegelati, see fillArmInstructionSet(). Executions on lanes
+* do not update the archive, and an engine must not outlive the generation
+* in which it is created.
+*/
+class LaneExecutionEngine : public TPG::TPGExecutionEngine {
+protected:
+    /// Line of a decoded program, operands are rows of the rows buffer
+    struct LaneLine {
+        uint64_t instruction;
+        uint64_t destination;
+        uint64_t operands[3];
+    };
+
+    const Environment &environment;
+
+    /// Register rows, followed by ARM_OBSERVATION_SIZE observation rows
+    std::vector<double> rows;
+
+    std::unordered_map<const Program::Program *, std::vector<LaneLine>> decodedPrograms;
+
+    /// Teams visited by the current executeFromRoot(), with the mask of the lanes that visited them
+    std::vector<std::pair<const TPG::TPGVertex *, uint32_t>> visitedTeams;
+
+    /// Mask of the lanes that visited a team during the current executeFromRoot()
+    uint32_t getVisitedLanes(const TPG::TPGVertex *team) const;
+
+    /// Arms whose decisions are taken by executeFromRoot()
+    ArmLearnWrapperBatch batch;
+
+    /// Returns the decoded lines of a program
+    const std::vector<LaneLine> &decode(const Program::Program &program);
+
+    /// Executes a program over all lanes, result[l] being the bid of lane l
+    void executeProgram(const std::vector<LaneLine> &lines, double *result);
+
+public:
+    /**
+    * \brief Constructor.
+    *
+    * \param[in] env environment of the graph, whose data sources are the ones of the ArmLearnWrapper.
+    * \param[in] wrapper wrapper cloned in each lane of the batch.
+    */
+    LaneExecutionEngine(const Environment &env, const ArmLearnWrapper &wrapper, Archive *archive = NULL);
+
+    /// Lanes of the engine
+    ArmLearnWrapperBatch &getBatch();
+
+    /**
+    * \brief Executes a root on each lane of the mask.
+    *
+    * \param[in] observations observations of the lanes, see ArmLearnWrapperBatch::copyObservations().
+    * \param[in] lanes bit l is set to execute the root on lane l.
+    * \param[out] actions action chosen by the root for each lane of the mask.
+    */
+    void executeFromRoot(const TPG::TPGVertex &root, const double *observations, uint32_t lanes, uint64_t *actions);
+
+    using TPG::TPGExecutionEngine::executeFromRoot;
+};
+
+#endif //ARMGEGELATI_LANEEXECUTIONENGINE_H
@@ -0,0 +1,92 @@
+#include <cstring>
+
+#include "MemoizingExecutionEngine.h"
+
+bool ObservationKey::operator==(const ObservationKey &other) const {
+    return std::memcmp(values, other.values, sizeof(values)) == 0;
+}
+
+size_t ObservationKeyHash::operator()(const ObservationKey &key) const {
+    // FNV-1a on the bytes of the values
+    uint64_t hash = 14695981039346656037ULL;
+    auto bytes = (const unsigned char *) key.values;
+    for (size_t i = 0; i < sizeof(key.values); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+MemoizingExecutionEngine::MemoizingExecutionEngine(const Environment &env, size_t maxNbDecisions, Archive *archive)
+        : TPGExecutionEngine(env, archive), maxNbDecisions(maxNbDecisions) {
+}
+
+uint64_t MemoizingExecutionEngine::executeDecision(const TPG::TPGVertex &root, const ArmLearnWrapper &le) {
+    if (&le != observedWrapper) {
+        // remembered results belong to the previous wrapper
+        clearDecisions();
+        observedWrapper = &le;
+    }
+    if (maxNbDecisions == 0) {
+        nbMisses++;
+        return ((const TPG::TPGAction *) this->executeFromRoot(root).back())->getActionID();
+    }
+
+    if (&root != cachedRoot || decisions.size() >= maxNbDecisions) {
+        decisions.clear();
+        cachedRoot = &root;
+    }
+
+    ObservationKey key;
+    le.copyObservation(key.values);
+
+    auto decision = decisions.find(key);
+    if (decision != decisions.end()) {
+        nbHits++;
+        return decision->second;
+    }
+
+    nbMisses++;
+    uint64_t actionID = ((const TPG::TPGAction *) this->executeFromRoot(root).back())->getActionID();
+    decisions.emplace(key, actionID);
+    return actionID;
+}
+
+double MemoizingExecutionEngine::evaluateEdge(const TPG::TPGEdge &edge) {
+    ProgramJit::CompiledProgram compiled = (jit != nullptr && observedWrapper != nullptr)
+                                           ? jit->getCompiledProgram(edge.getProgram()) : nullptr;
+    if (compiled == nullptr) {
+        return TPGExecutionEngine::evaluateEdge(edge);
+    }
+
+    if (observationVersion != observedWrapper->getInputVersion()) {
+        observedWrapper->copyObservation(observation);
+        observationVersion = observedWrapper->getInputVersion();
+    }
+    // data sources of the ArmLearnWrapper: cartesianDif then motorPos
+    const double *in[2] = {observation, observation + 3};
+    nbCompiledExecutions++;
+    return compiled(in);
+}
+
+void MemoizingExecutionEngine::setJit(const ProgramJit *programJit) {
+    jit = programJit;
+}
+
+void MemoizingExecutionEngine::clearDecisions() {
+    decisions.clear();
+    cachedRoot = nullptr;
+    observationVersion = UINT64_MAX;
+}
+
+uint64_t MemoizingExecutionEngine::getNbHits() const {
+    return nbHits;
+}
+
+uint64_t MemoizingExecutionEngine::getNbMisses() const {
+    return nbMisses;
+}
+
+uint64_t MemoizingExecutionEngine::getNbCompiledExecutions() const {
+    return nbCompiledExecutions;
+}
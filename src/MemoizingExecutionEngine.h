@@ -0,0 +1,107 @@
+#ifndef ARMGEGELATI_MEMOIZINGEXECUTIONENGINE_H
+#define ARMGEGELATI_MEMOIZINGEXECUTIONENGINE_H
+
+#include <unordered_map>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+#include "ProgramJit.h"
+
+/// Values of the data sources of the ArmLearnWrapper, see ArmLearnWrapper::copyObservation()
+struct ObservationKey {
+    double values[ARM_OBSERVATION_SIZE];
+
+    bool operator==(const ObservationKey &other) const;
+};
+
+struct ObservationKeyHash {
+    size_t operator()(const ObservationKey &key) const;
+};
+
+/**
+* \brief TPGExecutionEngine remembering the decisions of the current root.
+*
+* Programs only read the data sources of the ArmLearnWrapper and registers
+* are reset before each program execution, so the action chosen by a root only
+* depends on the observation. Servo positions are integers, so trajectories
+* often revisit observations, within an episode and across episodes.
+*
+* Decisions are kept for a single root, and forgotten when another root is
+* executed or when too many decisions are kept. An engine must not outlive
+* the generation in which it is created, since a mutated graph may reuse the
+* address of a deleted root. Executions whose decision is remembered do not
+* update the archive.
+*
+* When a ProgramJit is given, compiled programs are executed natively during
+* executeDecision(), on a copy of the observation of the wrapper. Native
+* executions do not update the archive either.
+*/
+class MemoizingExecutionEngine : public TPG::TPGExecutionEngine {
+protected:
+    /// Root whose decisions are remembered
+    const TPG::TPGVertex *cachedRoot = nullptr;
+
+    std::unordered_map<ObservationKey, uint64_t, ObservationKeyHash> decisions;
+
+    /// Number of decisions above which decisions are forgotten, 0 to never remember decisions
+    size_t maxNbDecisions;
+
+    /// Wrapper observed by the last call to executeDecision()
+    const ArmLearnWrapper *observedWrapper = nullptr;
+
+    uint64_t nbHits = 0;
+
+    uint64_t nbMisses = 0;
+
+    /// Compiled programs, nullptr to interpret all programs
+    const ProgramJit *jit = nullptr;
+
+    /// Observation of observedWrapper given to compiled programs
+    double observation[ARM_OBSERVATION_SIZE];
+
+    /// Input version of observedWrapper when observation was copied
+    uint64_t observationVersion = UINT64_MAX;
+
+    uint64_t nbCompiledExecutions = 0;
+
+public:
+    /**
+    * \brief Constructor, see TPG::TPGExecutionEngine.
+    *
+    * \param[in] maxNbDecisions number of decisions above which decisions are
+    * forgotten, 0 to never remember decisions.
+    */
+    explicit MemoizingExecutionEngine(const Environment &env, size_t maxNbDecisions = 1 << 16,
+                                      Archive *archive = NULL);
+
+    virtual ~MemoizingExecutionEngine() = default;
+
+    /**
+    * \brief Returns the action chosen by the root for the current observation of the wrapper.
+    *
+    * The graph is only executed if this observation was not seen by the
+    * root since it became the cached root.
+    */
+    uint64_t executeDecision(const TPG::TPGVertex &root, const ArmLearnWrapper &le);
+
+    /// Executes the compiled function of the program of the edge when there is one
+    double evaluateEdge(const TPG::TPGEdge &edge) override;
+
+    /// Sets the compiled programs executed natively, nullptr to interpret all programs
+    void setJit(const ProgramJit *programJit);
+
+    /// Forgets all decisions
+    virtual void clearDecisions();
+
+    /// Number of decisions returned without executing the graph
+    uint64_t getNbHits() const;
+
+    /// Number of decisions that executed the graph
+    uint64_t getNbMisses() const;
+
+    /// Number of programs executed natively
+    uint64_t getNbCompiledExecutions() const;
+};
+
+#endif //ARMGEGELATI_MEMOIZINGEXECUTIONENGINE_H
@@ -0,0 +1,70 @@
+#include "ObservationProbe.h"
+
+// Number of steps between two recorded observations
+#define RECORD_STRIDE 25
+
+// Number of recorded observations per episode
+#define OBSERVATIONS_PER_EPISODE 8
+
+size_t ActionSignatureHash::operator()(const std::vector<uint64_t> &signature) const {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t action : signature) {
+        hash ^= action;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ObservationProbe::ObservationProbe(const Instructions::Set &set, unsigned int nbRegisters)
+        : env(set, getDataSources(), nbRegisters), tee(env) {
+}
+
+std::vector<std::reference_wrapper<const Data::DataHandler>> ObservationProbe::getDataSources() {
+    std::vector<std::reference_wrapper<const Data::DataHandler>> result;
+    result.emplace_back(cartesianDif);
+    result.emplace_back(motorPos);
+    return result;
+}
+
+void ObservationProbe::record(const ArmLearnWrapper &wrapper, uint64_t nbObservations, uint64_t seed) {
+    observations.clear();
+    std::unique_ptr<Learn::LearningEnvironment> clone(wrapper.clone());
+    auto &le = dynamic_cast<ArmLearnWrapper &>(*clone);
+    // random walks are not trajectories of policies
+    le.setRecorder(nullptr);
+    Mutator::RNG rng(seed);
+
+    for (uint64_t episode = 0; observations.size() < nbObservations; episode++) {
+        le.reset(episode);
+        for (int i = 0; i < OBSERVATIONS_PER_EPISODE && observations.size() < nbObservations; i++) {
+            observations.push_back(le.getObservation());
+            for (int step = 0; step < RECORD_STRIDE; step++) {
+                le.doAction(rng.getUnsignedInt64(0, le.getNbActions() - 1));
+            }
+        }
+    }
+}
+
+size_t ObservationProbe::getNbObservations() const {
+    return observations.size();
+}
+
+const std::vector<double> &ObservationProbe::getObservation(size_t i) const {
+    return observations.at(i);
+}
+
+std::vector<uint64_t> ObservationProbe::getActionSignature(const TPG::TPGVertex &root) {
+    std::vector<uint64_t> signature;
+    signature.reserve(observations.size());
+    for (auto &observation : observations) {
+        for (size_t i = 0; i < 3; i++) {
+            cartesianDif.setDataAt(typeid(double), i, observation[i]);
+        }
+        for (size_t i = 0; i < 6; i++) {
+            motorPos.setDataAt(typeid(double), i, observation[3 + i]);
+        }
+        signature.push_back(((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID());
+    }
+    return signature;
+}
@@ -0,0 +1,69 @@
+#ifndef ARMGEGELATI_OBSERVATIONPROBE_H
+#define ARMGEGELATI_OBSERVATIONPROBE_H
+
+#include <vector>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+
+/// Hash of the actions taken by a root on the observations of an ObservationProbe
+struct ActionSignatureHash {
+    size_t operator()(const std::vector<uint64_t> &signature) const;
+};
+
+/**
+* \brief Fixed set of observations of the ArmLearnWrapper used to compare roots.
+*
+* The observations are recorded once, then each root is executed on all of
+* them. Roots taking the same action on every observation are considered
+* behaviourally identical, so only one of them needs to be evaluated.
+*
+* The probe holds data handlers with the layout of the data sources of the
+* ArmLearnWrapper, so that programs of a TPGGraph built on the wrapper can be
+* executed on them.
+*/
+class ObservationProbe {
+protected:
+    /// Same order and size as ArmLearnWrapper::getDataSources()
+    Data::PrimitiveTypeArray<double> cartesianDif{3};
+
+    Data::PrimitiveTypeArray<double> motorPos{6};
+
+    Environment env;
+
+    TPG::TPGExecutionEngine tee;
+
+    /// Recorded values of cartesianDif followed by motorPos
+    std::vector<std::vector<double>> observations;
+
+    std::vector<std::reference_wrapper<const Data::DataHandler>> getDataSources();
+
+public:
+    /**
+    * \brief Constructor.
+    *
+    * \param[in] set the instruction set of the TPGGraph of probed roots.
+    * \param[in] nbRegisters the number of registers of its Environment.
+    */
+    ObservationProbe(const Instructions::Set &set, unsigned int nbRegisters);
+
+    /**
+    * \brief Records observations of a clone of the wrapper.
+    *
+    * The clone plays episodes of pseudo-random actions on the goals of the
+    * wrapper, one observation being recorded every few steps, so that
+    * observations spread over the reachable states.
+    */
+    void record(const ArmLearnWrapper &wrapper, uint64_t nbObservations, uint64_t seed);
+
+    size_t getNbObservations() const;
+
+    /// Recorded values of observation i, cartesianDif followed by motorPos
+    const std::vector<double> &getObservation(size_t i) const;
+
+    /// Returns the action taken by the root on each observation
+    std::vector<uint64_t> getActionSignature(const TPG::TPGVertex &root);
+};
+
+#endif //ARMGEGELATI_OBSERVATIONPROBE_H
@@ -0,0 +1,100 @@
+#include <algorithm>
+
+#include "PipelinedControlLoop.h"
+
+PipelinedControlLoop::PipelinedControlLoop(ArmLearnWrapper &le, const Instructions::Set &set,
+                                           unsigned int nbRegisters)
+        : le(le), env(set, {cartesianDif, motorPos}, nbRegisters), tee(env),
+          feedbackThread(&PipelinedControlLoop::waitFeedbacks, this) {
+}
+
+PipelinedControlLoop::~PipelinedControlLoop() {
+    {
+        std::lock_guard<std::mutex> lock(feedbackMutex);
+        stopping = true;
+    }
+    feedbackCondition.notify_all();
+    feedbackThread.join();
+}
+
+Environment &PipelinedControlLoop::getEnvironment() {
+    return env;
+}
+
+uint64_t PipelinedControlLoop::getNbSpeculations() const {
+    return nbSpeculations;
+}
+
+uint64_t PipelinedControlLoop::getNbHits() const {
+    return nbHits;
+}
+
+void PipelinedControlLoop::waitFeedbacks() {
+    std::unique_lock<std::mutex> lock(feedbackMutex);
+    while (true) {
+        feedbackCondition.wait(lock, [this]() { return feedbackPending || stopping; });
+        if (stopping) {
+            return;
+        }
+        lock.unlock();
+        le.waitActionFeedback();
+        lock.lock();
+        feedbackPending = false;
+        feedbackCondition.notify_all();
+    }
+}
+
+uint64_t PipelinedControlLoop::decide(const TPG::TPGVertex &root, const double *observation) {
+    for (size_t i = 0; i < 3; i++) {
+        cartesianDif.setDataAt(typeid(double), i, observation[i]);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        motorPos.setDataAt(typeid(double), i, observation[3 + i]);
+    }
+    return ((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID();
+}
+
+uint64_t PipelinedControlLoop::run(const TPG::TPGVertex &root, uint64_t nbSteps) {
+    double observation[ARM_OBSERVATION_SIZE];
+    double predicted[ARM_OBSERVATION_SIZE];
+
+    le.copyObservation(observation);
+    uint64_t action = decide(root, observation);
+    uint64_t step = 0;
+    while (step < nbSteps && !le.isTerminal()) {
+        le.startAction(action);
+        {
+            std::lock_guard<std::mutex> lock(feedbackMutex);
+            feedbackPending = true;
+        }
+        feedbackCondition.notify_all();
+
+        // The last speculation of the loop is useless
+        uint64_t speculative = 0;
+        bool speculated = step + 1 < nbSteps;
+        if (speculated) {
+            le.copyPredictedObservation(predicted);
+            speculative = decide(root, predicted);
+            nbSpeculations++;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(feedbackMutex);
+            feedbackCondition.wait(lock, [this]() { return !feedbackPending; });
+        }
+        le.finishAction();
+        step++;
+
+        if (speculated) {
+            le.copyObservation(observation);
+            if (std::equal(observation, observation + ARM_OBSERVATION_SIZE, predicted)) {
+                action = speculative;
+                nbHits++;
+            } else {
+                // the arm did not reach the predicted state, e.g. it was blocked
+                action = decide(root, observation);
+            }
+        }
+    }
+    return step;
+}
@@ -0,0 +1,94 @@
+#ifndef ARMGEGELATI_PIPELINEDCONTROLLOOP_H
+#define ARMGEGELATI_PIPELINEDCONTROLLOOP_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+
+/**
+* \brief Control loop deciding the next action while the arm moves.
+*
+* In a serial loop, each step waits for the decision of the policy, then for
+* the motion of the arm. Here, once the position of an action is sent to the
+* device, the next action is decided speculatively from the observation
+* predicted for this position (see ArmLearnWrapper::copyPredictedObservation()),
+* while another thread waits for the feedback of the device. When the
+* observed state matches the prediction, the speculative action is sent at
+* once, so the decision time is hidden behind the motion; otherwise, it is
+* discarded and the action is decided again from the observed state.
+*
+* The loop takes the same actions as a serial loop. Decisions are made on its
+* own data handlers, filled with observed or predicted values, so roots must
+* be built for an Environment with the layout of the ArmLearnWrapper, e.g.
+* getEnvironment().
+*/
+class PipelinedControlLoop {
+protected:
+    ArmLearnWrapper &le;
+
+    /// Same order and size as ArmLearnWrapper::getDataSources()
+    Data::PrimitiveTypeArray<double> cartesianDif{3};
+
+    Data::PrimitiveTypeArray<double> motorPos{6};
+
+    Environment env;
+
+    TPG::TPGExecutionEngine tee;
+
+    /// Thread waiting for the feedback of the device
+    std::thread feedbackThread;
+
+    std::mutex feedbackMutex;
+
+    std::condition_variable feedbackCondition;
+
+    /// Set to request a waitActionFeedback(), reset by the feedback thread once done
+    bool feedbackPending = false;
+
+    bool stopping = false;
+
+    uint64_t nbSpeculations = 0;
+
+    uint64_t nbHits = 0;
+
+    /// Runs waitActionFeedback() on request, until destruction
+    void waitFeedbacks();
+
+    /// Returns the action taken by the root on the observation
+    uint64_t decide(const TPG::TPGVertex &root, const double *observation);
+
+public:
+    /**
+    * \brief Prepares the loop and its feedback thread.
+    *
+    * \param[in] le the environment moved by the loop, with its device.
+    * \param[in] set the instruction set of the executed roots.
+    * \param[in] nbRegisters the number of registers of their Environment.
+    */
+    PipelinedControlLoop(ArmLearnWrapper &le, const Instructions::Set &set, unsigned int nbRegisters);
+
+    /// Stops the feedback thread
+    ~PipelinedControlLoop();
+
+    /// Environment with the layout of the ArmLearnWrapper, on which executed graphs can be built or imported
+    Environment &getEnvironment();
+
+    /**
+    * \brief Runs the root from the current state of the environment.
+    *
+    * \return the number of actions done, less than nbSteps if the episode ended.
+    */
+    uint64_t run(const TPG::TPGVertex &root, uint64_t nbSteps);
+
+    /// Number of actions decided speculatively
+    uint64_t getNbSpeculations() const;
+
+    /// Number of speculative actions that were sent to the device
+    uint64_t getNbHits() const;
+};
+
+#endif //ARMGEGELATI_PIPELINEDCONTROLLOOP_H
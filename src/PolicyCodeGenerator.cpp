@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "ArmInstructions.h"
+#include "PolicyCodeGenerator.h"
+
+/// C expression of an instruction of the armGegelati instruction set, see fillArmInstructionSet()
+static std::string instructionExpression(uint64_t instruction, const std::vector<std::string> &operands) {
+    const std::string &a = operands.at(0);
+    const std::string &b = operands.at(1);
+    const std::string &c = operands.at(2);
+    switch (instruction) {
+        case ARM_MINUS:
+            return a + " - " + b;
+        case ARM_ADD:
+            return a + " + " + b;
+        case ARM_TIMES:
+            return a + " * " + b;
+        case ARM_DIVIDE:
+            return a + " / " + b;
+        case ARM_COND:
+            return "(" + a + " < " + b + ") ? -" + a + " : " + a;
+        case ARM_COS:
+            return "cos(" + a + ")";
+        case ARM_SIN:
+            return "sin(" + a + ")";
+        case ARM_HYPOT3:
+            return "sqrt(" + a + " * " + a + " + " + b + " * " + b + " + " + c + " * " + c + ")";
+        case ARM_ATAN2:
+            return "atan2(" + a + ", " + b + ")";
+        case ARM_CLAMP:
+            return "fmin(fmax(" + a + ", -fabs(" + b + ")), fabs(" + b + "))";
+        case ARM_SERVO_TO_RADIAN: {
+            std::stringstream expression;
+            expression.precision(17);
+            expression << "(" << a << " - " << SERVO_CENTER << ") * " << SERVO_TO_RADIAN;
+            return expression.str();
+        }
+        case ARM_SIGN:
+            return "(double) ((" + a + " > 0) - (" + a + " < 0))";
+        default:
+            throw std::runtime_error("Instruction " + std::to_string(instruction) + " can not be generated.");
+    }
+}
+
+/// C expression reading an operand
+static std::string operandExpression(const std::pair<uint64_t, uint64_t> &operand, const Environment &env) {
+    if (operand.first == 0) {
+        return "reg[" + std::to_string(operand.second % env.getNbRegisters()) + "]";
+    }
+    uint64_t addressSpace = env.getDataSources().at(operand.first - 1).get().getAddressSpace(typeid(double));
+    return "in[" + std::to_string(operand.first - 1) + "][" + std::to_string(operand.second % addressSpace) + "]";
+}
+
+std::string generateProgramC(const PolicyGraph::ProgramCopy &program, const Environment &env,
+                             const std::string &functionName, bool isStatic) {
+    std::stringstream code;
+    code << (isStatic ? "static " : "") << "double " << functionName << "(const double *const *in) {\n";
+    code << "    double reg[" << env.getNbRegisters() << "] = {0};\n";
+    if (program.lines.empty()) {
+        code << "    (void) in;\n";
+    }
+    for (const PolicyGraph::LineCopy &line : program.lines) {
+        std::vector<std::string> operands(3, "0");
+        for (size_t i = 0; i < std::min<size_t>(line.operands.size(), 3); i++) {
+            operands[i] = operandExpression(line.operands[i], env);
+        }
+        code << "    reg[" << line.destination << "] = " << instructionExpression(line.instruction, operands) << ";\n";
+    }
+    code << "    return isnan(reg[0]) ? -INFINITY : reg[0];\n";
+    code << "}\n";
+    return code.str();
+}
+
+std::string generatePolicyC(const PolicyGraph &policy, const Environment &env, const std::string &functionName) {
+    if (policy.nbRoots == 0) {
+        throw std::runtime_error("The policy has no root.");
+    }
+
+    std::stringstream code;
+    code << "/* Generated by policyCodeGen, do not edit. */\n";
+    code << "#include <math.h>\n";
+    code << "#include <stdint.h>\n";
+    code << "#include <string.h>\n\n";
+    code << "#define NB_VERTICES " << policy.vertices.size() << "\n\n";
+
+    // Programs
+    for (size_t programIdx = 0; programIdx < policy.programs.size(); programIdx++) {
+        code << generateProgramC(policy.programs[programIdx], env, "program" + std::to_string(programIdx)) << "\n";
+    }
+
+    // Outgoing edges of each vertex, in evaluation order
+    std::vector<std::vector<const PolicyGraph::EdgeCopy *>> outgoingEdges(policy.vertices.size());
+    for (const PolicyGraph::EdgeCopy &edge : policy.edges) {
+        outgoingEdges[edge.source].push_back(&edge);
+    }
+
+    // Teams
+    for (size_t vertexIdx = 0; vertexIdx < policy.vertices.size(); vertexIdx++) {
+        if (!policy.vertices[vertexIdx].isAction) {
+            code << "static uint64_t team" << vertexIdx << "(const double *const *in, unsigned char *visited);\n";
+        }
+    }
+    code << "\n";
+    for (size_t vertexIdx = 0; vertexIdx < policy.vertices.size(); vertexIdx++) {
+        if (policy.vertices[vertexIdx].isAction) {
+            continue;
+        }
+        code << "static uint64_t team" << vertexIdx << "(const double *const *in, unsigned char *visited) {\n";
+        code << "    double bestBid = -INFINITY;\n";
+        code << "    int best = -1;\n";
+        code << "    double bid;\n";
+        code << "    visited[" << vertexIdx << "] = 1;\n";
+        const auto &edges = outgoingEdges[vertexIdx];
+        for (size_t i = 0; i < edges.size(); i++) {
+            uint64_t destination = edges[i]->destination;
+            std::string evaluation = "bid = program" + std::to_string(edges[i]->program) + "(in);\n"
+                                     + "        if (bid >= bestBid) {\n"
+                                     + "            bestBid = bid;\n"
+                                     + "            best = " + std::to_string(i) + ";\n"
+                                     + "        }\n";
+            if (policy.vertices[destination].isAction) {
+                code << "    {\n        " << evaluation << "    }\n";
+            } else {
+                code << "    if (!visited[" << destination << "]) {\n        " << evaluation << "    }\n";
+            }
+        }
+        code << "    switch (best) {\n";
+        for (size_t i = 0; i < edges.size(); i++) {
+            const PolicyGraph::VertexCopy &destination = policy.vertices[edges[i]->destination];
+            code << "        case " << i << ":\n";
+            if (destination.isAction) {
+                code << "            return " << destination.actionID << "u;\n";
+            } else {
+                code << "            return team" << edges[i]->destination << "(in, visited);\n";
+            }
+        }
+        code << "        default:\n";
+        code << "            return 0u;\n";
+        code << "    }\n";
+        code << "}\n\n";
+    }
+
+    // Entry point
+    code << "uint64_t " << functionName << "(const double *cartesianDif, const double *motorPos) {\n";
+    code << "    const double *in[2] = {cartesianDif, motorPos};\n";
+    if (policy.vertices[0].isAction) {
+        code << "    (void) in;\n";
+        code << "    return " << policy.vertices[0].actionID << "u;\n";
+    } else {
+        code << "    unsigned char visited[NB_VERTICES];\n";
+        code << "    memset(visited, 0, sizeof(visited));\n";
+        code << "    return team0(in, visited);\n";
+    }
+    code << "}\n";
+
+    return code.str();
+}
@@ -0,0 +1,47 @@
+#ifndef ARMGEGELATI_POLICYCODEGENERATOR_H
+#define ARMGEGELATI_POLICYCODEGENERATOR_H
+
+#include <string>
+
+#include <gegelati.h>
+
+#include "PolicyGraph.h"
+
+/**
+* \brief Generates the C function of a single program.
+*
+* The function has the signature
+* \code
+* double functionName(const double *const *in);
+* \endcode
+* where in[i] is the data source i of the environment, and returns the
+* result of the program, -INFINITY instead of NaN. Same instruction set
+* restriction as generatePolicyC().
+*/
+std::string generateProgramC(const PolicyGraph::ProgramCopy &program, const Environment &env,
+                             const std::string &functionName, bool isStatic = true);
+
+/**
+* \brief Generates the C source of a policy, executed without any graph interpreter.
+*
+* Each program becomes a straight-line function over a local register array,
+* with the instructions inlined, and each team becomes a function evaluating
+* its edges in order, as TPG::TPGExecutionEngine does: the edge with the
+* highest bid wins, ties go to the last one, NaN bids count as -infinity and
+* edges leading to an already visited team are skipped.
+*
+* The generated C99 file defines
+* \code
+* uint64_t functionName(const double *cartesianDif, const double *motorPos);
+* \endcode
+* which returns the action chosen by the first root of the policy for the
+* data sources of the ArmLearnWrapper.
+*
+* Instructions are identified by their index in the instruction set, which
+* must be the one of armGegelati, see fillArmInstructionSet().
+* Throws std::runtime_error if the policy uses another instruction.
+*/
+std::string generatePolicyC(const PolicyGraph &policy, const Environment &env,
+                            const std::string &functionName = "policyInference");
+
+#endif //ARMGEGELATI_POLICYCODEGENERATOR_H
@@ -0,0 +1,36 @@
+#include <iostream>
+
+#include "ObservationProbe.h"
+#include "PolicyExport.h"
+#include "PolicyGraph.h"
+
+bool exportCompactPolicy(const TPG::TPGVertex &root, const Environment &env, const ArmLearnWrapper &wrapper,
+                         const char *path, uint64_t nbObservations) {
+    PolicyGraph policy = PolicyGraph::extract(root);
+    PolicyGraph compacted = policy;
+    compacted.compact(env);
+
+    TPG::TPGGraph originalGraph(env);
+    const TPG::TPGVertex &originalRoot = policy.insertInto(originalGraph);
+    TPG::TPGGraph compactGraph(env);
+    const TPG::TPGVertex &compactRoot = compacted.insertInto(compactGraph);
+
+    // Both policies must take the same decisions
+    ObservationProbe probe(env.getInstructionSet(), env.getNbRegisters());
+    probe.record(wrapper, nbObservations, 0);
+    bool equivalent = probe.getActionSignature(originalRoot) == probe.getActionSignature(compactRoot);
+
+    if (equivalent) {
+        std::cout << "Compacted policy: " << policy.vertices.size() << " -> " << compacted.vertices.size()
+                  << " vertices, " << policy.getNbLines() << " -> " << compacted.getNbLines() << " lines"
+                  << std::endl;
+        File::TPGGraphDotExporter dotExporter(path, compactGraph);
+        dotExporter.print();
+    } else {
+        std::cerr << "Compacted policy does not take the same decisions, exporting it without compaction."
+                  << std::endl;
+        File::TPGGraphDotExporter dotExporter(path, originalGraph);
+        dotExporter.print();
+    }
+    return equivalent;
+}
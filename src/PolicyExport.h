@@ -0,0 +1,23 @@
+#ifndef ARMGEGELATI_POLICYEXPORT_H
+#define ARMGEGELATI_POLICYEXPORT_H
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+
+/**
+* \brief Exports a compacted copy of a policy in a dot file.
+*
+* The policy reachable from the root is extracted, compacted (see
+* PolicyGraph::compact()) and inserted in a new TPGGraph. The original and
+* compacted policies are executed on observations recorded from the wrapper,
+* and the compacted policy is only exported if they take the same action on
+* all of them. Otherwise, the policy is exported without compaction.
+*
+* \param[in] wrapper the environment whose observations are recorded, with valid goals.
+* \return true if the compacted policy was exported.
+*/
+bool exportCompactPolicy(const TPG::TPGVertex &root, const Environment &env, const ArmLearnWrapper &wrapper,
+                         const char *path, uint64_t nbObservations = 1000);
+
+#endif //ARMGEGELATI_POLICYEXPORT_H
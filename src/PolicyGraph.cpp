@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <map>
+
+#include "PolicyGraph.h"
+
+PolicyGraph::ProgramCopy PolicyGraph::copyProgram(const Program::Program &program) {
+    const Environment &env = program.getEnvironment();
+    ProgramCopy copy;
+    for (uint64_t lineIdx = 0; lineIdx < program.getNbLines(); lineIdx++) {
+        const Program::Line &line = program.getLine(lineIdx);
+        LineCopy lineCopy;
+        lineCopy.instruction = line.getInstructionIndex();
+        lineCopy.destination = line.getDestinationIndex();
+        for (uint64_t i = 0; i < env.getMaxNbOperands(); i++) {
+            lineCopy.operands.push_back(line.getOperand(i));
+        }
+        for (uint64_t i = 0; i < env.getMaxNbParameters(); i++) {
+            lineCopy.parameters.push_back(line.getParameter(i));
+        }
+        copy.lines.push_back(lineCopy);
+    }
+    return copy;
+}
+
+PolicyGraph PolicyGraph::extract(const TPG::TPGVertex &root) {
+    return extract(std::vector<const TPG::TPGVertex *>({&root}));
+}
+
+PolicyGraph PolicyGraph::extract(const std::vector<const TPG::TPGVertex *> &roots) {
+    PolicyGraph policy;
+
+    std::map<const TPG::TPGVertex *, uint64_t> vertexIndices;
+    std::map<const Program::Program *, uint64_t> programIndices;
+    std::vector<const TPG::TPGVertex *> toVisit;
+
+    auto addVertex = [&](const TPG::TPGVertex *vertex) {
+        auto found = vertexIndices.find(vertex);
+        if (found != vertexIndices.end()) {
+            return found->second;
+        }
+        VertexCopy copy;
+        auto action = dynamic_cast<const TPG::TPGAction *>(vertex);
+        if (action != nullptr) {
+            copy.isAction = true;
+            copy.actionID = action->getActionID();
+        }
+        uint64_t idx = policy.vertices.size();
+        policy.vertices.push_back(copy);
+        vertexIndices[vertex] = idx;
+        toVisit.push_back(vertex);
+        return idx;
+    };
+
+    auto addProgram = [&](const Program::Program &program) {
+        auto found = programIndices.find(&program);
+        if (found != programIndices.end()) {
+            return found->second;
+        }
+        uint64_t idx = policy.programs.size();
+        policy.programs.push_back(copyProgram(program));
+        programIndices[&program] = idx;
+        return idx;
+    };
+
+    // roots are added first, so that they are the first vertices
+    for (const TPG::TPGVertex *root : roots) {
+        addVertex(root);
+    }
+    policy.nbRoots = roots.size();
+
+    // toVisit grows while it is scanned, vertices are numbered in breadth-first order
+    for (size_t visited = 0; visited < toVisit.size(); visited++) {
+        const TPG::TPGVertex *vertex = toVisit[visited];
+        uint64_t source = vertexIndices.at(vertex);
+        for (const TPG::TPGEdge *edge : vertex->getOutgoingEdges()) {
+            EdgeCopy copy;
+            copy.source = source;
+            copy.destination = addVertex(edge->getDestination());
+            copy.program = addProgram(edge->getProgram());
+            policy.edges.push_back(copy);
+        }
+    }
+
+    return policy;
+}
+
+const TPG::TPGVertex &PolicyGraph::insertInto(TPG::TPGGraph &graph) const {
+    return *insertRootsInto(graph).front();
+}
+
+std::vector<const TPG::TPGVertex *> PolicyGraph::insertRootsInto(TPG::TPGGraph &graph) const {
+    // Existing actions of the graph
+    std::map<uint64_t, const TPG::TPGVertex *> actions;
+    for (const TPG::TPGVertex *vertex : graph.getVertices()) {
+        auto action = dynamic_cast<const TPG::TPGAction *>(vertex);
+        if (action != nullptr) {
+            actions.emplace(action->getActionID(), action);
+        }
+    }
+
+    std::vector<const TPG::TPGVertex *> newVertices;
+    for (const VertexCopy &vertex : vertices) {
+        if (!vertex.isAction) {
+            newVertices.push_back(&graph.addNewTeam());
+        } else if (actions.count(vertex.actionID) != 0) {
+            newVertices.push_back(actions.at(vertex.actionID));
+        } else {
+            const TPG::TPGVertex *action = &graph.addNewAction(vertex.actionID);
+            actions.emplace(vertex.actionID, action);
+            newVertices.push_back(action);
+        }
+    }
+
+    std::vector<std::shared_ptr<Program::Program>> newPrograms;
+    for (const ProgramCopy &program : programs) {
+        auto newProgram = std::make_shared<Program::Program>(graph.getEnvironment());
+        for (const LineCopy &line : program.lines) {
+            Program::Line &newLine = newProgram->addNewLine();
+            newLine.setInstructionIndex(line.instruction);
+            newLine.setDestinationIndex(line.destination);
+            for (uint64_t i = 0; i < line.operands.size(); i++) {
+                newLine.setOperand(i, line.operands[i].first, line.operands[i].second);
+            }
+            for (uint64_t i = 0; i < line.parameters.size(); i++) {
+                newLine.setParameter(i, line.parameters[i]);
+            }
+        }
+        newPrograms.push_back(newProgram);
+    }
+
+    for (const EdgeCopy &edge : edges) {
+        graph.addNewEdge(*newVertices[edge.source], *newVertices[edge.destination], newPrograms[edge.program]);
+    }
+
+    newVertices.resize(nbRoots);
+    return newVertices;
+}
+
+/// Writes the lines of a program
+static void writeProgram(ByteWriter &writer, const PolicyGraph::ProgramCopy &program) {
+    writer.writeVarUInt(program.lines.size());
+    for (const PolicyGraph::LineCopy &line : program.lines) {
+        writer.writeVarUInt(line.instruction);
+        writer.writeVarUInt(line.destination);
+        writer.writeVarUInt(line.operands.size());
+        for (auto &operand : line.operands) {
+            writer.writeVarUInt(operand.first);
+            writer.writeVarUInt(operand.second);
+        }
+        writer.writeVarUInt(line.parameters.size());
+        for (auto &parameter : line.parameters) {
+            writer.writeRaw(&parameter, sizeof(Parameter));
+        }
+    }
+}
+
+void PolicyGraph::serialize(std::vector<uint8_t> &buffer) const {
+    ByteWriter writer(buffer);
+
+    writer.writeVarUInt(nbRoots);
+    writer.writeVarUInt(vertices.size());
+    for (const VertexCopy &vertex : vertices) {
+        // actions are stored as actionID + 1, teams as 0
+        writer.writeVarUInt(vertex.isAction ? vertex.actionID + 1 : 0);
+    }
+
+    writer.writeVarUInt(programs.size());
+    for (const ProgramCopy &program : programs) {
+        writeProgram(writer, program);
+    }
+
+    writer.writeVarUInt(edges.size());
+    for (const EdgeCopy &edge : edges) {
+        writer.writeVarUInt(edge.source);
+        writer.writeVarUInt(edge.destination);
+        writer.writeVarUInt(edge.program);
+    }
+}
+
+PolicyGraph PolicyGraph::deserialize(ByteReader &reader) {
+    PolicyGraph policy;
+
+    // counts are bounded by the minimum size of their items, see ByteReader::readCount()
+
+    policy.nbRoots = reader.readVarUInt();
+    policy.vertices.resize(reader.readCount(1));
+    for (VertexCopy &vertex : policy.vertices) {
+        uint64_t value = reader.readVarUInt();
+        vertex.isAction = (value != 0);
+        vertex.actionID = vertex.isAction ? value - 1 : 0;
+    }
+
+    policy.programs.resize(reader.readCount(1));
+    for (ProgramCopy &program : policy.programs) {
+        program.lines.resize(reader.readCount(4));
+        for (LineCopy &line : program.lines) {
+            line.instruction = reader.readVarUInt();
+            line.destination = reader.readVarUInt();
+            line.operands.resize(reader.readCount(2));
+            for (auto &operand : line.operands) {
+                operand.first = reader.readVarUInt();
+                operand.second = reader.readVarUInt();
+            }
+            line.parameters.resize(reader.readCount(sizeof(Parameter)));
+            for (auto &parameter : line.parameters) {
+                reader.readRaw(&parameter, sizeof(Parameter));
+            }
+        }
+    }
+
+    policy.edges.resize(reader.readCount(3));
+    for (EdgeCopy &edge : policy.edges) {
+        edge.source = reader.readVarUInt();
+        edge.destination = reader.readVarUInt();
+        edge.program = reader.readVarUInt();
+        if (edge.source >= policy.vertices.size() || edge.destination >= policy.vertices.size()
+            || edge.program >= policy.programs.size()) {
+            throw std::runtime_error("Invalid edge in serialized policy.");
+        }
+    }
+
+    if (policy.nbRoots > policy.vertices.size()) {
+        throw std::runtime_error("Invalid number of roots in serialized policy.");
+    }
+    return policy;
+}
+
+void PolicyGraph::removeUnreachableVertices() {
+    // New index of each reachable vertex, in breadth-first order from the roots
+    std::vector<int64_t> newIndices(vertices.size(), -1);
+    std::vector<uint64_t> order;
+    for (uint64_t root = 0; root < nbRoots; root++) {
+        newIndices[root] = (int64_t) order.size();
+        order.push_back(root);
+    }
+    std::vector<std::vector<uint64_t>> outgoingEdges(vertices.size());
+    for (uint64_t edgeIdx = 0; edgeIdx < edges.size(); edgeIdx++) {
+        outgoingEdges[edges[edgeIdx].source].push_back(edgeIdx);
+    }
+    for (size_t visited = 0; visited < order.size(); visited++) {
+        for (uint64_t edgeIdx : outgoingEdges[order[visited]]) {
+            uint64_t destination = edges[edgeIdx].destination;
+            if (newIndices[destination] < 0) {
+                newIndices[destination] = (int64_t) order.size();
+                order.push_back(destination);
+            }
+        }
+    }
+
+    std::vector<VertexCopy> newVertices;
+    for (uint64_t vertex : order) {
+        newVertices.push_back(vertices[vertex]);
+    }
+    // Edges keep their relative order, which is the evaluation order of teams
+    std::vector<EdgeCopy> newEdges;
+    for (uint64_t vertex : order) {
+        for (uint64_t edgeIdx : outgoingEdges[vertex]) {
+            EdgeCopy edge = edges[edgeIdx];
+            edge.source = newIndices[edge.source];
+            edge.destination = newIndices[edge.destination];
+            newEdges.push_back(edge);
+        }
+    }
+    vertices = std::move(newVertices);
+    edges = std::move(newEdges);
+}
+
+PolicyGraph::ProgramCopy PolicyGraph::compactProgram(const ProgramCopy &program, const Environment &env) {
+    const Instructions::Set &set = env.getInstructionSet();
+    uint64_t nbRegisters = env.getNbRegisters();
+    const auto &dataSources = env.getDataSources();
+
+    // Backward liveness of registers, register 0 holds the result
+    std::vector<bool> live(nbRegisters, false);
+    live[0] = true;
+    std::vector<LineCopy> usefulLines;
+    for (auto line = program.lines.rbegin(); line != program.lines.rend(); line++) {
+        if (!live[line->destination]) {
+            continue;
+        }
+        const Instructions::Instruction &instruction = set.getInstruction(line->instruction);
+        LineCopy useful = *line;
+        live[line->destination] = false;
+        for (uint64_t i = 0; i < useful.operands.size(); i++) {
+            auto &operand = useful.operands[i];
+            if (i >= instruction.getNbOperands()) {
+                // operands unused by the instruction
+                operand = {0, 0};
+            } else if (operand.first == 0) {
+                operand.second %= nbRegisters;
+                live[operand.second] = true;
+            } else {
+                operand.second %= dataSources.at(operand.first - 1).get().getAddressSpace(
+                        instruction.getOperandTypes().at(i));
+            }
+        }
+        usefulLines.push_back(useful);
+    }
+    std::reverse(usefulLines.begin(), usefulLines.end());
+
+    // Renumber registers in order of first use, register 0 remains the result
+    std::vector<int64_t> registers(nbRegisters, -1);
+    registers[0] = 0;
+    uint64_t nbUsedRegisters = 1;
+    auto renumber = [&](uint64_t reg) {
+        if (registers[reg] < 0) {
+            registers[reg] = (int64_t) nbUsedRegisters++;
+        }
+        return (uint64_t) registers[reg];
+    };
+    for (LineCopy &line : usefulLines) {
+        for (uint64_t i = 0; i < set.getInstruction(line.instruction).getNbOperands(); i++) {
+            if (line.operands[i].first == 0) {
+                line.operands[i].second = renumber(line.operands[i].second);
+            }
+        }
+        line.destination = renumber(line.destination);
+    }
+
+    ProgramCopy compacted;
+    compacted.lines = std::move(usefulLines);
+    return compacted;
+}
+
+uint64_t PolicyGraph::hashProgram(const ProgramCopy &program) {
+    std::vector<uint8_t> bytes;
+    ByteWriter writer(bytes);
+    writeProgram(writer, program);
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint8_t byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void PolicyGraph::compact(const Environment &env) {
+    removeUnreachableVertices();
+
+    std::vector<ProgramCopy> newPrograms;
+    std::map<std::vector<uint8_t>, uint64_t> programIndices;
+    std::vector<uint64_t> newProgramIndices;
+    for (const ProgramCopy &program : programs) {
+        ProgramCopy compacted = compactProgram(program, env);
+
+        // Programs that became identical are merged
+        std::vector<uint8_t> key;
+        ByteWriter writer(key);
+        writeProgram(writer, compacted);
+        auto inserted = programIndices.emplace(key, newPrograms.size());
+        if (inserted.second) {
+            newPrograms.push_back(std::move(compacted));
+        }
+        newProgramIndices.push_back(inserted.first->second);
+    }
+
+    // Only keep programs of remaining edges
+    std::vector<int64_t> usedPrograms(newPrograms.size(), -1);
+    programs.clear();
+    for (EdgeCopy &edge : edges) {
+        uint64_t program = newProgramIndices[edge.program];
+        if (usedPrograms[program] < 0) {
+            usedPrograms[program] = (int64_t) programs.size();
+            programs.push_back(newPrograms[program]);
+        }
+        edge.program = usedPrograms[program];
+    }
+}
+
+uint64_t PolicyGraph::getNbLines() const {
+    uint64_t nbLines = 0;
+    for (const ProgramCopy &program : programs) {
+        nbLines += program.lines.size();
+    }
+    return nbLines;
+}
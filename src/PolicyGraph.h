@@ -0,0 +1,138 @@
+#ifndef ARMGEGELATI_POLICYGRAPH_H
+#define ARMGEGELATI_POLICYGRAPH_H
+
+#include <gegelati.h>
+
+#include "ByteStream.h"
+
+/**
+* \brief Standalone copy of the subgraph of a TPG reachable from one or several roots.
+*
+* A PolicyGraph does not reference the TPGGraph or Environment it was
+* extracted from, so it can be kept after the original graph is modified and
+* inserted in another TPGGraph whose Environment has the same instructions,
+* data sources and number of registers.
+*
+* Vertices [0, nbRoots) are the roots, in the order given at extraction. Edges
+* are listed in the order of the outgoing edges of their source, which is the
+* order in which a team evaluates them. Vertices and programs shared by several
+* roots are copied only once.
+*
+* A PolicyGraph can be serialized in a compact byte buffer, to be sent to
+* another process.
+*/
+struct PolicyGraph {
+    /// Copy of a Program::Line
+    struct LineCopy {
+        uint64_t instruction = 0;
+        uint64_t destination = 0;
+        /// Pairs of data source index and location
+        std::vector<std::pair<uint64_t, uint64_t>> operands;
+        std::vector<Parameter> parameters;
+    };
+
+    /// Copy of a Program::Program
+    struct ProgramCopy {
+        std::vector<LineCopy> lines;
+    };
+
+    /// Copy of a TPG::TPGTeam or of a TPG::TPGAction
+    struct VertexCopy {
+        bool isAction = false;
+        uint64_t actionID = 0;
+    };
+
+    /// Copy of a TPG::TPGEdge
+    struct EdgeCopy {
+        uint64_t source = 0;
+        uint64_t destination = 0;
+        uint64_t program = 0;
+    };
+
+    /// Number of roots, which are the first vertices
+    uint64_t nbRoots = 0;
+
+    std::vector<VertexCopy> vertices;
+
+    std::vector<EdgeCopy> edges;
+
+    /// Programs, shared by edges referencing the same index
+    std::vector<ProgramCopy> programs;
+
+    /// Copies the lines of a program
+    static ProgramCopy copyProgram(const Program::Program &program);
+
+    /**
+    * \brief Removes the introns of a program, see compact().
+    *
+    * \param[in] env Environment of the program.
+    */
+    static ProgramCopy compactProgram(const ProgramCopy &program, const Environment &env);
+
+    /// Hash of the content of a program, equal for identical programs
+    static uint64_t hashProgram(const ProgramCopy &program);
+
+    /**
+    * \brief Copies the subgraph reachable from a root.
+    */
+    static PolicyGraph extract(const TPG::TPGVertex &root);
+
+    /**
+    * \brief Copies the subgraph reachable from several roots.
+    */
+    static PolicyGraph extract(const std::vector<const TPG::TPGVertex *> &roots);
+
+    /**
+    * \brief Adds a copy of the policy in a TPGGraph.
+    *
+    * Action vertices already present in the graph are reused, so that the
+    * graph does not get duplicated actions.
+    * \return the vertex copying the root of the policy.
+    */
+    const TPG::TPGVertex &insertInto(TPG::TPGGraph &graph) const;
+
+    /**
+    * \brief Adds a copy of the policy in a TPGGraph, see insertInto().
+    *
+    * \return the vertices copying the roots of the policy, in order.
+    */
+    std::vector<const TPG::TPGVertex *> insertRootsInto(TPG::TPGGraph &graph) const;
+
+    /**
+    * \brief Removes the vertices that can not be reached from the roots.
+    *
+    * Vertices are renumbered in breadth-first order from the roots. Policies
+    * returned by extract() have no such vertex, but deserialized ones may.
+    */
+    void removeUnreachableVertices();
+
+    /**
+    * \brief Reduces the policy to what influences its decisions.
+    *
+    * Removes unreachable vertices, then removes from each program the
+    * introns, the lines whose result never reaches register 0, which holds
+    * the result of the program. Registers still used are renumbered in order
+    * of first use, operands unused by their instruction are cleared and
+    * locations are reduced to the address space of their data source, so
+    * programs that became identical are merged. The decisions of the
+    * policy are unchanged.
+    *
+    * \param[in] env Environment of the graph the policy was extracted from.
+    */
+    void compact(const Environment &env);
+
+    /// Total number of lines of the programs
+    uint64_t getNbLines() const;
+
+    /// Appends the serialized policy to a byte buffer
+    void serialize(std::vector<uint8_t> &buffer) const;
+
+    /**
+    * \brief Reads a policy written by serialize().
+    *
+    * Throws std::runtime_error if the buffer is not a valid policy.
+    */
+    static PolicyGraph deserialize(ByteReader &reader);
+};
+
+#endif //ARMGEGELATI_POLICYGRAPH_H
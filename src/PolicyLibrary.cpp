@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "PolicyLibrary.h"
+
+// Maximum number of entries of a leaf of the KD-tree
+#define LIBRARY_LEAF_SIZE 4
+
+static const char LIBRARY_MAGIC[8] = "ARMPLIB";
+
+double GoalRegion::squaredDistance(const double *goal) const {
+    double distance = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double outside = std::max(std::max(min[i] - goal[i], goal[i] - max[i]), 0.0);
+        distance += outside * outside;
+    }
+    return distance;
+}
+
+PolicyLibrary::PolicyLibrary(const std::vector<const TPG::TPGVertex *> &roots, const std::vector<Entry> &entries,
+                             const Environment &env) : entries(entries) {
+    if (roots.size() != entries.size()) {
+        throw std::runtime_error("A policy library needs one entry per root.");
+    }
+    policies = PolicyGraph::extract(roots);
+    policies.compact(env);
+    buildIndex();
+}
+
+size_t PolicyLibrary::getNbPolicies() const {
+    return entries.size();
+}
+
+const PolicyLibrary::Entry &PolicyLibrary::getEntry(size_t i) const {
+    return entries.at(i);
+}
+
+const PolicyGraph &PolicyLibrary::getPolicies() const {
+    return policies;
+}
+
+void PolicyLibrary::buildIndex() {
+    order.resize(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    nodes.clear();
+    if (!entries.empty()) {
+        buildNode(0, entries.size());
+    }
+}
+
+uint32_t PolicyLibrary::buildNode(uint32_t begin, uint32_t end) {
+    uint32_t nodeIdx = nodes.size();
+    nodes.emplace_back();
+
+    GoalRegion bounds = entries[order[begin]].region;
+    double minCenter[3];
+    double maxCenter[3];
+    for (int i = 0; i < 3; i++) {
+        minCenter[i] = std::numeric_limits<double>::infinity();
+        maxCenter[i] = -std::numeric_limits<double>::infinity();
+    }
+    for (uint32_t j = begin; j < end; j++) {
+        const GoalRegion &region = entries[order[j]].region;
+        for (int i = 0; i < 3; i++) {
+            bounds.min[i] = std::min(bounds.min[i], region.min[i]);
+            bounds.max[i] = std::max(bounds.max[i], region.max[i]);
+            double center = (region.min[i] + region.max[i]) / 2;
+            minCenter[i] = std::min(minCenter[i], center);
+            maxCenter[i] = std::max(maxCenter[i], center);
+        }
+    }
+    nodes[nodeIdx].bounds = bounds;
+    nodes[nodeIdx].begin = begin;
+    nodes[nodeIdx].end = end;
+    if (end - begin <= LIBRARY_LEAF_SIZE) {
+        return nodeIdx;
+    }
+
+    // Median split of the centers along their widest axis
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (maxCenter[i] - minCenter[i] > maxCenter[axis] - minCenter[axis]) {
+            axis = i;
+        }
+    }
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [this, axis](uint32_t a, uint32_t b) {
+                         return entries[a].region.min[axis] + entries[a].region.max[axis] <
+                                entries[b].region.min[axis] + entries[b].region.max[axis];
+                     });
+
+    // nodes may be reallocated by the children
+    uint32_t left = buildNode(begin, middle);
+    uint32_t right = buildNode(middle, end);
+    nodes[nodeIdx].left = left;
+    nodes[nodeIdx].right = right;
+    return nodeIdx;
+}
+
+size_t PolicyLibrary::findPolicy(const double *goal) const {
+    if (nodes.empty()) {
+        throw std::runtime_error("The policy library is empty.");
+    }
+
+    size_t best = 0;
+    double bestDistance = std::numeric_limits<double>::infinity();
+    double bestScore = -std::numeric_limits<double>::infinity();
+
+    uint32_t stack[64];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node &node = nodes[stack[--stackSize]];
+        // equally near regions may have a better score
+        if (node.bounds.squaredDistance(goal) > bestDistance) {
+            continue;
+        }
+        if (node.left == 0) {
+            for (uint32_t j = node.begin; j < node.end; j++) {
+                const Entry &entry = entries[order[j]];
+                double distance = entry.region.squaredDistance(goal);
+                if (distance < bestDistance || (distance == bestDistance && entry.score > bestScore)) {
+                    best = order[j];
+                    bestDistance = distance;
+                    bestScore = entry.score;
+                }
+            }
+            continue;
+        }
+        // the nearest child is visited first, to prune the other one sooner
+        bool leftFirst = nodes[node.left].bounds.squaredDistance(goal) <=
+                         nodes[node.right].bounds.squaredDistance(goal);
+        stack[stackSize++] = leftFirst ? node.right : node.left;
+        stack[stackSize++] = leftFirst ? node.left : node.right;
+    }
+    return best;
+}
+
+void PolicyLibrary::save(const std::string &path) const {
+    std::vector<uint8_t> buffer;
+    ByteWriter writer(buffer);
+    writer.writeRaw(LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    writer.writeVarUInt(1);
+    writer.writeVarUInt(entries.size());
+    for (const Entry &entry : entries) {
+        for (int i = 0; i < 3; i++) {
+            writer.writeDouble(entry.region.min[i]);
+            writer.writeDouble(entry.region.max[i]);
+        }
+        writer.writeDouble(entry.score);
+    }
+    policies.serialize(buffer);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char *) buffer.data(), buffer.size());
+    if (!file.good()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+PolicyLibrary PolicyLibrary::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ByteReader reader(buffer.data(), buffer.size());
+    char magic[sizeof(LIBRARY_MAGIC)];
+    reader.readRaw(magic, sizeof(magic));
+    if (!std::equal(magic, magic + sizeof(magic), LIBRARY_MAGIC) || reader.readVarUInt() != 1) {
+        throw std::runtime_error(path + " is not a policy library.");
+    }
+
+    PolicyLibrary library;
+    // 7 doubles per entry, its region and its score, checked before allocating the entries
+    library.entries.resize(reader.readCount(7 * sizeof(double)));
+    for (Entry &entry : library.entries) {
+        for (int i = 0; i < 3; i++) {
+            entry.region.min[i] = reader.readDouble();
+            entry.region.max[i] = reader.readDouble();
+        }
+        entry.score = reader.readDouble();
+    }
+    library.policies = PolicyGraph::deserialize(reader);
+    if (library.policies.nbRoots != library.entries.size() || !reader.atEnd()) {
+        throw std::runtime_error(path + " is not a policy library.");
+    }
+    library.buildIndex();
+    return library;
+}
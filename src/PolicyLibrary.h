@@ -0,0 +1,120 @@
+#ifndef ARMGEGELATI_POLICYLIBRARY_H
+#define ARMGEGELATI_POLICYLIBRARY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "PolicyGraph.h"
+
+/// Axis-aligned box of goals, in the cartesian coordinates of the arm
+struct GoalRegion {
+    double min[3] = {0, 0, 0};
+
+    double max[3] = {0, 0, 0};
+
+    /// Squared euclidean distance from the goal to the box, 0 inside
+    double squaredDistance(const double *goal) const;
+};
+
+/**
+* \brief Set of policies specialized on regions of the workspace.
+*
+* Each policy is a root tagged with the goal region it was trained or
+* validated on, and its validation score. For a new goal, findPolicy()
+* returns the policy of the nearest region, the best scored one when several
+* regions contain the goal, so that small regional policies trained in
+* parallel can be served as one.
+*
+* Regions are indexed by a KD-tree over their centers, each node bounding
+* the regions of its subtree, so a lookup only visits the few nodes whose
+* bounds are closer than the best region found.
+*
+* Libraries are stored in a binary file holding the regions and a
+* PolicyGraph of all the roots, in which shared teams and programs are copied
+* once.
+*/
+class PolicyLibrary {
+public:
+    /// Region and score of a policy
+    struct Entry {
+        GoalRegion region;
+
+        /// Validation score of the policy on its region, the higher the better
+        double score = 0.0;
+    };
+
+protected:
+    /// Node of the KD-tree, covering entries order[begin, end)
+    struct Node {
+        /// Union of the regions of the node
+        GoalRegion bounds;
+
+        uint32_t begin = 0;
+
+        uint32_t end = 0;
+
+        /// Children, 0 for leaves (the root is never a child)
+        uint32_t left = 0;
+
+        uint32_t right = 0;
+    };
+
+    /// Root i of policies is the policy of entries[i]
+    PolicyGraph policies;
+
+    std::vector<Entry> entries;
+
+    /// Indices of entries, grouped by node
+    std::vector<uint32_t> order;
+
+    /// Nodes of the KD-tree, the first one being its root
+    std::vector<Node> nodes;
+
+    /// Builds the KD-tree over the entries
+    void buildIndex();
+
+    /// Builds the subtree of order[begin, end), returns the index of its root node
+    uint32_t buildNode(uint32_t begin, uint32_t end);
+
+public:
+    PolicyLibrary() = default;
+
+    /**
+    * \brief Creates a library from roots and their entries.
+    *
+    * The policies are extracted from the roots, which may belong to
+    * different TPGGraph with the same Environment, and compacted.
+    *
+    * \param[in] env Environment of the graphs of the roots.
+    */
+    PolicyLibrary(const std::vector<const TPG::TPGVertex *> &roots, const std::vector<Entry> &entries,
+                  const Environment &env);
+
+    size_t getNbPolicies() const;
+
+    const Entry &getEntry(size_t i) const;
+
+    /// Policies of all entries, root i being the one of getEntry(i)
+    const PolicyGraph &getPolicies() const;
+
+    /**
+    * \brief Index of the policy to use for the goal.
+    *
+    * The policy of the region nearest to the goal, regions containing the
+    * goal being at distance 0, and the one with the best score among
+    * equally near regions. Throws std::runtime_error if the library is
+    * empty.
+    */
+    size_t findPolicy(const double *goal) const;
+
+    /// Writes the library to a file, throws std::runtime_error if it can not be written
+    void save(const std::string &path) const;
+
+    /// Reads a library written by save(), throws std::runtime_error if the file is not a library
+    static PolicyLibrary load(const std::string &path);
+};
+
+#endif //ARMGEGELATI_POLICYLIBRARY_H
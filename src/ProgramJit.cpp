@@ -0,0 +1,147 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "PolicyCodeGenerator.h"
+#include "ProgramJit.h"
+
+/// Name of the C function of a program
+static std::string compiledProgramName(uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "jit_%016" PRIx64, hash);
+    return name;
+}
+
+ProgramJit::ProgramJit(uint64_t minAge, std::string compiler, std::string directory)
+        : minAge(minAge), compiler(std::move(compiler)), directory(std::move(directory)) {
+}
+
+ProgramJit::~ProgramJit() {
+    for (void *library : libraries) {
+        dlclose(library);
+    }
+}
+
+void ProgramJit::update(const TPG::TPGGraph &graph, const Environment &env, uint64_t generation) {
+    std::unordered_map<const Program::Program *, ProgramAge> newAges;
+    std::unordered_map<const Program::Program *, uint64_t> hashes;
+    std::vector<std::pair<uint64_t, PolicyGraph::ProgramCopy>> toCompile;
+    for (const auto &edge : graph.getEdges()) {
+        const Program::Program &program = edge->getProgram();
+        if (newAges.count(&program) > 0) {
+            continue;
+        }
+
+        PolicyGraph::ProgramCopy compacted = PolicyGraph::compactProgram(PolicyGraph::copyProgram(program), env);
+        uint64_t hash = PolicyGraph::hashProgram(compacted);
+        hashes[&program] = hash;
+
+        // A program mutated in place, or allocated where a deleted one was, starts a new life
+        auto previous = ages.find(&program);
+        ProgramAge age = (previous != ages.end() && previous->second.hash == hash) ? previous->second
+                                                                                  : ProgramAge{hash, generation};
+        newAges.emplace(&program, age);
+
+        if (!disabled && generation - age.firstGeneration >= minAge && cache.count(hash) == 0) {
+            // nullptr until compiled, so that identical programs are compiled once
+            cache.emplace(hash, nullptr);
+            toCompile.emplace_back(hash, std::move(compacted));
+        }
+    }
+    ages = std::move(newAges);
+
+    if (!toCompile.empty() && !compile(toCompile, env)) {
+        std::cerr << "Program JIT disabled, programs of the next generations are interpreted." << std::endl;
+        disabled = true;
+    }
+
+    compiledPrograms.clear();
+    for (const auto &hash : hashes) {
+        auto compiled = cache.find(hash.second);
+        if (compiled != cache.end() && compiled->second != nullptr) {
+            compiledPrograms.emplace(hash.first, compiled->second);
+        }
+    }
+}
+
+bool ProgramJit::compile(const std::vector<std::pair<uint64_t, PolicyGraph::ProgramCopy>> &programs,
+                         const Environment &env) {
+    // Private directory (0700), so that other users can not plant or swap the files
+    std::string privateDirectory = directory + "/armgegelati_jit_XXXXXX";
+    if (mkdtemp(&privateDirectory[0]) == nullptr) {
+        std::cerr << "Could not create a directory in " << directory << std::endl;
+        return false;
+    }
+    std::string sourcePath = privateDirectory + "/programs.c";
+    std::string libraryPath = privateDirectory + "/programs.so";
+
+    std::vector<uint64_t> hashes;
+    std::ostringstream code;
+    code << "#include <math.h>\n\n";
+    for (const auto &program : programs) {
+        try {
+            code << generateProgramC(program.second, env, compiledProgramName(program.first), false) << "\n";
+            hashes.push_back(program.first);
+        } catch (const std::runtime_error &) {
+            // instruction without C expression, the program stays interpreted
+        }
+    }
+
+    int fd = open(sourcePath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    FILE *source = (fd >= 0) ? fdopen(fd, "w") : nullptr;
+    bool written = source != nullptr && fputs(code.str().c_str(), source) >= 0;
+    if (source != nullptr) {
+        written = (fclose(source) == 0) && written;
+    } else if (fd >= 0) {
+        close(fd);
+    }
+    if (!written) {
+        std::cerr << "Could not write " << sourcePath << std::endl;
+        std::remove(sourcePath.c_str());
+        rmdir(privateDirectory.c_str());
+        return false;
+    }
+
+    // No FMA contraction, so that compiled programs compute the same values as the interpreter
+    std::string command = compiler + " -O2 -ffp-contract=off -shared -fPIC -o " + libraryPath + " " + sourcePath
+                          + " -lm";
+    int status = std::system(command.c_str());
+    std::remove(sourcePath.c_str());
+    if (status != 0) {
+        std::cerr << "Could not compile programs with \"" << command << "\"" << std::endl;
+        std::remove(libraryPath.c_str());
+        rmdir(privateDirectory.c_str());
+        return false;
+    }
+
+    void *library = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    // The loaded library stays mapped once its file is removed
+    std::remove(libraryPath.c_str());
+    rmdir(privateDirectory.c_str());
+    if (library == nullptr) {
+        std::cerr << "Could not load compiled programs: " << dlerror() << std::endl;
+        return false;
+    }
+    libraries.push_back(library);
+
+    for (uint64_t hash : hashes) {
+        cache[hash] = (CompiledProgram) dlsym(library, compiledProgramName(hash).c_str());
+    }
+    return true;
+}
+
+ProgramJit::CompiledProgram ProgramJit::getCompiledProgram(const Program::Program &program) const {
+    auto compiled = compiledPrograms.find(&program);
+    return (compiled != compiledPrograms.end()) ? compiled->second : nullptr;
+}
+
+size_t ProgramJit::getNbCompiledPrograms() const {
+    return compiledPrograms.size();
+}
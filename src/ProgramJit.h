@@ -0,0 +1,110 @@
+#ifndef ARMGEGELATI_PROGRAMJIT_H
+#define ARMGEGELATI_PROGRAMJIT_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "PolicyGraph.h"
+
+/**
+* \brief Compiles to native code the programs that survive many generations.
+*
+* Most programs of a generation were already in the graph during the
+* previous ones, and are executed again by every root that reaches them.
+* Before each evaluation of the roots, update() looks for the programs
+* present in the graph for at least minAge generations, generates their C
+* code with generateProgramC() once their introns are removed, compiles them
+* in a shared library with an external C compiler, and loads it with dlopen.
+* Floating-point contraction is disabled, so that compiled programs give the
+* same values as the interpreter.
+*
+* Compiled functions are cached by hash of the compacted program, so a
+* program that was mutated back to a compiled one, or equal to it up to its
+* introns, is not compiled again. Programs that can not be compiled keep
+* being interpreted, and the first compilation error disables the JIT.
+*
+* The compiled function of a program is looked up with getCompiledProgram(),
+* which is safe to call from several threads between two update().
+*/
+class ProgramJit {
+public:
+    /// Compiled program, in[i] being the values of data source i of the ArmLearnWrapper
+    typedef double (*CompiledProgram)(const double *const *in);
+
+protected:
+    /// Number of generations a program must survive before being compiled
+    uint64_t minAge;
+
+    /// Command of the C compiler
+    std::string compiler;
+
+    /// Directory in which a private directory is created for each compilation
+    std::string directory;
+
+    /// Hash of a program and first generation where it was seen with this hash
+    struct ProgramAge {
+        uint64_t hash;
+        uint64_t firstGeneration;
+    };
+
+    std::unordered_map<const Program::Program *, ProgramAge> ages;
+
+    /// Compiled function of each hash, nullptr when the program can not be compiled
+    std::unordered_map<uint64_t, CompiledProgram> cache;
+
+    /// Compiled function of each program of the graph given to the last update()
+    std::unordered_map<const Program::Program *, CompiledProgram> compiledPrograms;
+
+    /// Handles of the loaded libraries, closed by the destructor
+    std::vector<void *> libraries;
+
+    /// Set after a compilation error
+    bool disabled = false;
+
+    /**
+    * \brief Compiles the given programs in a single library and fills the cache.
+    *
+    * \return false if the library could not be built or loaded.
+    */
+    bool compile(const std::vector<std::pair<uint64_t, PolicyGraph::ProgramCopy>> &programs,
+                 const Environment &env);
+
+public:
+    /**
+    * \brief Constructor.
+    *
+    * \param[in] minAge number of generations a program must survive before being compiled.
+    * \param[in] compiler command of the C compiler, called with gcc-like options.
+    * \param[in] directory directory in which private (0700) directories are created for
+    * temporary sources and libraries.
+    */
+    explicit ProgramJit(uint64_t minAge = 10, std::string compiler = "cc", std::string directory = "/tmp");
+
+    /// Closes the loaded libraries
+    ~ProgramJit();
+
+    ProgramJit(const ProgramJit &) = delete;
+
+    ProgramJit &operator=(const ProgramJit &) = delete;
+
+    /**
+    * \brief Ages the programs of the graph and compiles the old enough ones.
+    *
+    * Must be called before each evaluation of the roots, with no thread
+    * calling getCompiledProgram().
+    *
+    * \param[in] env environment of the graph, whose data sources are the ones of the ArmLearnWrapper.
+    */
+    void update(const TPG::TPGGraph &graph, const Environment &env, uint64_t generation);
+
+    /// Returns the compiled function of a program of the graph, nullptr if it is interpreted
+    CompiledProgram getCompiledProgram(const Program::Program &program) const;
+
+    /// Number of programs of the graph executed natively
+    size_t getNbCompiledPrograms() const;
+};
+
+#endif //ARMGEGELATI_PROGRAMJIT_H
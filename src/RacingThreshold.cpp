@@ -0,0 +1,48 @@
+#include <cmath>
+#include <limits>
+
+#include "RacingThreshold.h"
+
+RacingThreshold::RacingThreshold() : threshold(-std::numeric_limits<double>::infinity()) {
+}
+
+void RacingThreshold::reset(size_t nbSurvivors) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->nbSurvivors = nbSurvivors;
+    bestResults = decltype(bestResults)();
+    threshold = -std::numeric_limits<double>::infinity();
+}
+
+void RacingThreshold::addResult(double result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (nbSurvivors == 0) {
+        return;
+    }
+    if (bestResults.size() < nbSurvivors) {
+        bestResults.push(result);
+    } else if (result > bestResults.top()) {
+        bestResults.pop();
+        bestResults.push(result);
+    }
+    if (bestResults.size() == nbSurvivors) {
+        threshold = bestResults.top();
+    }
+}
+
+double RacingThreshold::getThreshold() const {
+    return threshold;
+}
+
+double normalQuantile(double probability) {
+    // Bisection on the cumulative distribution function
+    double low = -10.0, high = 10.0;
+    for (int i = 0; i < 100; i++) {
+        double mid = (low + high) / 2;
+        if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < probability) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return (low + high) / 2;
+}
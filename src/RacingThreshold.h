@@ -0,0 +1,52 @@
+#ifndef ARMGEGELATI_RACINGTHRESHOLD_H
+#define ARMGEGELATI_RACINGTHRESHOLD_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+/**
+* \brief Score a root must reach to survive the decimation of a generation.
+*
+* Evaluation threads add the final result of each root they evaluate. Once
+* nbSurvivors results are known, the threshold is the worst of the
+* nbSurvivors best results: a root whose result can not exceed it will be
+* removed by the decimation, whatever the results of roots still evaluated.
+*/
+class RacingThreshold {
+protected:
+    /// Number of roots kept by the decimation
+    size_t nbSurvivors = 0;
+
+    std::mutex mutex;
+
+    /// Best results added so far, worst first
+    std::priority_queue<double, std::vector<double>, std::greater<double>> bestResults;
+
+    /// Copy of the threshold, read by threads without locking
+    std::atomic<double> threshold;
+
+public:
+    RacingThreshold();
+
+    /// Forgets all results, to be called before the evaluation of a generation
+    void reset(size_t nbSurvivors);
+
+    /// Adds the final result of a root
+    void addResult(double result);
+
+    /// Returns the threshold, -infinity until nbSurvivors results are known
+    double getThreshold() const;
+};
+
+/**
+* \brief Quantile of the standard normal distribution.
+*
+* \param[in] probability in ]0, 1[.
+* \return z such that P(X <= z) = probability.
+*/
+double normalQuantile(double probability);
+
+#endif //ARMGEGELATI_RACINGTHRESHOLD_H
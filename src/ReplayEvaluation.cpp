@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "ReplayEvaluation.h"
+
+ReplayEvaluator::TransitionKey::TransitionKey(const double *motorPos, uint64_t action) : action(action) {
+    for (size_t i = 0; i < 6; i++) {
+        motors[i] = (uint16_t) motorPos[i];
+    }
+}
+
+bool ReplayEvaluator::TransitionKey::operator==(const TransitionKey &other) const {
+    return action == other.action && std::equal(motors, motors + 6, other.motors);
+}
+
+size_t ReplayEvaluator::TransitionKeyHash::operator()(const TransitionKey &key) const {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint16_t motor : key.motors) {
+        hash ^= motor;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= key.action;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+ReplayEvaluator::ReplayContext::ReplayContext(const Instructions::Set &set, unsigned int nbRegisters)
+        : env(set, {cartesianDif, motorPos}, nbRegisters), tee(env) {
+}
+
+uint64_t ReplayEvaluator::ReplayContext::decide(const TPG::TPGVertex &root, const double *motors,
+                                                const double *cartesian, const double *goal) {
+    for (size_t i = 0; i < 3; i++) {
+        cartesianDif.setDataAt(typeid(double), i, goal[i] - cartesian[i]);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        motorPos.setDataAt(typeid(double), i, motors[i]);
+    }
+    return ((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID();
+}
+
+ReplayEvaluator::ReplayEvaluator(const std::string &path, const Instructions::Set &set, unsigned int nbRegisters,
+                                 size_t nbThreads)
+        : dataset(path), set(set), nbRegisters(nbRegisters), nbThreads(std::max<size_t>(nbThreads, 1)),
+          context(set, nbRegisters) {
+    // Records of an episode are interleaved with the ones of concurrent episodes
+    std::map<uint64_t, std::vector<std::pair<uint64_t, uint64_t>>> episodes;
+    for (uint64_t i = 0; i < dataset.getNbRecords(); i++) {
+        const TrajectoryRecord &record = dataset.getRecord(i);
+        episodes[record.episode].emplace_back(record.step, i);
+    }
+
+    for (auto &episode : episodes) {
+        auto &steps = episode.second;
+        std::sort(steps.begin(), steps.end());
+        episodeStarts.push_back(steps.front().second);
+        maxEpisodeLength = std::max<uint64_t>(maxEpisodeLength, steps.back().first - steps.front().first + 1);
+
+        for (size_t i = 0; i + 1 < steps.size(); i++) {
+            if (steps[i + 1].first != steps[i].first + 1) {
+                // steps overwritten in a ring file
+                continue;
+            }
+            const TrajectoryRecord &record = dataset.getRecord(steps[i].second);
+            transitions.emplace(TransitionKey(record.motorPos, record.action), steps[i + 1].second);
+        }
+    }
+}
+
+Environment &ReplayEvaluator::getEnvironment() {
+    return context.env;
+}
+
+size_t ReplayEvaluator::getNbTransitions() const {
+    return transitions.size();
+}
+
+size_t ReplayEvaluator::getNbEpisodes() const {
+    return episodeStarts.size();
+}
+
+ReplayScore ReplayEvaluator::evaluate(ReplayContext &replayContext, const TPG::TPGVertex &root,
+                                      uint64_t maxNbSteps) const {
+    ReplayScore score;
+
+    // Agreement with the recorded actions
+    uint64_t nbAgreements = 0;
+    for (uint64_t i = 0; i < dataset.getNbRecords(); i++) {
+        const TrajectoryRecord &record = dataset.getRecord(i);
+        if (replayContext.decide(root, record.motorPos, record.cartesianPos, record.goal) == record.action) {
+            nbAgreements++;
+        }
+    }
+    score.agreement = (dataset.getNbRecords() > 0) ? (double) nbAgreements / (double) dataset.getNbRecords() : 0.0;
+
+    // Rollouts in the transition table
+    for (uint64_t start : episodeStarts) {
+        const TrajectoryRecord &first = dataset.getRecord(start);
+        const double *motors = first.motorPos;
+        const double *cartesian = first.cartesianPos;
+        uint64_t nbSteps = 0;
+        while (nbSteps < maxNbSteps) {
+            uint64_t action = replayContext.decide(root, motors, cartesian, first.goal);
+            auto next = transitions.find(TransitionKey(motors, action));
+            if (next == transitions.end()) {
+                break;
+            }
+            const TrajectoryRecord &reached = dataset.getRecord(next->second);
+            motors = reached.motorPos;
+            cartesian = reached.cartesianPos;
+            nbSteps++;
+        }
+
+        double squaredDistance = 0.0;
+        for (size_t i = 0; i < 3; i++) {
+            squaredDistance += (first.goal[i] - cartesian[i]) * (first.goal[i] - cartesian[i]);
+        }
+        score.rolloutScore -= squaredDistance;
+        score.coverage += (maxNbSteps > 0) ? (double) nbSteps / (double) maxNbSteps : 1.0;
+    }
+    if (!episodeStarts.empty()) {
+        score.rolloutScore /= (double) episodeStarts.size();
+        score.coverage /= (double) episodeStarts.size();
+    }
+    return score;
+}
+
+std::vector<ReplayScore> ReplayEvaluator::evaluate(const std::vector<const TPG::TPGVertex *> &roots,
+                                                   uint64_t maxNbSteps) {
+    if (maxNbSteps == 0) {
+        maxNbSteps = maxEpisodeLength;
+    }
+
+    std::vector<ReplayScore> scores(roots.size());
+    std::atomic<size_t> nextRoot(0);
+    auto worker = [&]() {
+        ReplayContext threadContext(set, nbRegisters);
+        size_t rootIdx;
+        while ((rootIdx = nextRoot++) < roots.size()) {
+            scores[rootIdx] = evaluate(threadContext, *roots[rootIdx], maxNbSteps);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(nbThreads, roots.size()); i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return scores;
+}
@@ -0,0 +1,126 @@
+#ifndef ARMGEGELATI_REPLAYEVALUATION_H
+#define ARMGEGELATI_REPLAYEVALUATION_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "TrajectoryRecorder.h"
+
+/// Scores of a root on recorded trajectories, see ReplayEvaluator
+struct ReplayScore {
+    /// Fraction of the recorded steps on which the root takes the recorded action
+    double agreement = 0.0;
+
+    /// Mean over episodes of the opposite of the squared distance to the goal at the end of the replayed rollout
+    double rolloutScore = 0.0;
+
+    /// Mean over episodes of the fraction of the rollout steps whose transition was recorded
+    double coverage = 0.0;
+};
+
+/**
+* \brief Scores roots on a trajectory file, without any arm simulator.
+*
+* Roots are executed on the observations rebuilt from the records of a
+* TrajectoryRecorder, with the layout of the data sources of the
+* ArmLearnWrapper, and scored two ways:
+* - the agreement of their actions with the recorded ones, e.g. the ones of
+* a reference policy,
+* - rollouts in a transition table learned from the records: the servo
+* state reached by each recorded (servo state, action) pair. Each episode is
+* replayed from its first recorded state and goal, and stops after
+* maxNbSteps steps or on the first transition that was never recorded.
+*
+* Roots are dispatched on threads, each with its own data handlers and
+* execution engine. Transitions are keyed on the servo positions only, since
+* the arm moves the same way whatever the goal.
+*/
+class ReplayEvaluator {
+protected:
+    /// Servo positions and action of a transition
+    struct TransitionKey {
+        uint16_t motors[6];
+        uint64_t action;
+
+        TransitionKey(const double *motorPos, uint64_t action);
+
+        bool operator==(const TransitionKey &other) const;
+    };
+
+    struct TransitionKeyHash {
+        size_t operator()(const TransitionKey &key) const;
+    };
+
+    /// Data handlers, environment and engine of a thread
+    struct ReplayContext {
+        /// Same order and size as ArmLearnWrapper::getDataSources()
+        Data::PrimitiveTypeArray<double> cartesianDif{3};
+
+        Data::PrimitiveTypeArray<double> motorPos{6};
+
+        Environment env;
+
+        TPG::TPGExecutionEngine tee;
+
+        ReplayContext(const Instructions::Set &set, unsigned int nbRegisters);
+
+        /// Returns the action taken by the root on the state
+        uint64_t decide(const TPG::TPGVertex &root, const double *motors, const double *cartesian, const double *goal);
+    };
+
+    TrajectoryReader dataset;
+
+    const Instructions::Set &set;
+
+    unsigned int nbRegisters;
+
+    size_t nbThreads;
+
+    /// Context used to build graphs, see getEnvironment()
+    ReplayContext context;
+
+    /// Index of the record of the state reached by each recorded transition
+    std::unordered_map<TransitionKey, uint64_t, TransitionKeyHash> transitions;
+
+    /// Index of the first record of each episode
+    std::vector<uint64_t> episodeStarts;
+
+    /// Number of steps of the longest recorded episode
+    uint64_t maxEpisodeLength = 0;
+
+    /// Scores a root with the given context
+    ReplayScore evaluate(ReplayContext &replayContext, const TPG::TPGVertex &root, uint64_t maxNbSteps) const;
+
+public:
+    /**
+    * \brief Maps the trajectory file and learns its transitions.
+    *
+    * \param[in] set the instruction set of the evaluated roots.
+    * \param[in] nbRegisters the number of registers of their Environment.
+    * \param[in] nbThreads the number of threads evaluating roots.
+    */
+    ReplayEvaluator(const std::string &path, const Instructions::Set &set, unsigned int nbRegisters,
+                    size_t nbThreads);
+
+    /// Environment with the layout of the ArmLearnWrapper, on which graphs to evaluate can be built or imported
+    Environment &getEnvironment();
+
+    /// Number of recorded (servo state, action) pairs whose next state is known
+    size_t getNbTransitions() const;
+
+    /// Number of recorded episodes
+    size_t getNbEpisodes() const;
+
+    /**
+    * \brief Scores roots in parallel.
+    *
+    * \param[in] maxNbSteps the maximum number of steps of rollouts, 0 for
+    * the length of the longest recorded episode.
+    */
+    std::vector<ReplayScore> evaluate(const std::vector<const TPG::TPGVertex *> &roots, uint64_t maxNbSteps = 0);
+};
+
+#endif //ARMGEGELATI_REPLAYEVALUATION_H
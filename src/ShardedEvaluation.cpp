@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ArmLearnWrapper.h"
+#include "ArmLearningAgent.h"
+#include "ByteStream.h"
+#include "PolicyGraph.h"
+#include "ShardedEvaluation.h"
+
+int openShardSocket(const std::string &address, bool listening) {
+    int fd = -1;
+
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un addr = {};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (listening) {
+            unlink(path.c_str());
+            if (bind(fd, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+                close(fd);
+                return -1;
+            }
+        } else if (connect(fd, (sockaddr *) &addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (address.compare(0, 4, "tcp:") == 0) {
+        std::string hostPort = address.substr(4);
+        size_t separator = hostPort.rfind(':');
+        if (separator == std::string::npos) {
+            return -1;
+        }
+        std::string host = hostPort.substr(0, separator);
+        std::string port = hostPort.substr(separator + 1);
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        addrinfo *infos;
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &infos) != 0) {
+            return -1;
+        }
+        for (addrinfo *info = infos; info != nullptr && fd < 0; info = info->ai_next) {
+            fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            bool ok;
+            if (listening) {
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                ok = bind(fd, info->ai_addr, info->ai_addrlen) == 0 && listen(fd, 64) == 0;
+            } else {
+                ok = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+            }
+            if (!ok) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(infos);
+        return fd;
+    }
+
+    return -1;
+}
+
+/// Sends all bytes, returns false if the connection is lost
+static bool sendAll(int fd, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/// Receives exactly size bytes, returns false if the connection is lost
+static bool receiveAll(int fd, uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= received;
+    }
+    return true;
+}
+
+bool sendShardMessage(int fd, ShardMessage type, const std::vector<uint8_t> &payload) {
+    // header: type, then payload size on 8 little-endian bytes
+    uint8_t header[9];
+    header[0] = (uint8_t) type;
+    for (int i = 0; i < 8; i++) {
+        header[1 + i] = (uint8_t) ((uint64_t) payload.size() >> (8 * i));
+    }
+    return sendAll(fd, header, sizeof(header)) && sendAll(fd, payload.data(), payload.size());
+}
+
+bool receiveShardMessage(int fd, ShardMessage &type, std::vector<uint8_t> &payload, uint64_t maxSize) {
+    uint8_t header[9];
+    if (!receiveAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    type = (ShardMessage) header[0];
+    uint64_t size = 0;
+    for (int i = 0; i < 8; i++) {
+        size |= (uint64_t) header[1 + i] << (8 * i);
+    }
+    // the size is sent by the peer, it is checked before allocating
+    if (size > std::min(maxSize, SHARD_MESSAGE_MAX_SIZE)) {
+        return false;
+    }
+    payload.resize(size);
+    return receiveAll(fd, payload.data(), size);
+}
+
+ShardedEvaluator::ShardedEvaluator(const std::string &address, uint64_t shardSize, uint64_t shardTimeoutMs)
+        : address(address), shardSize(std::max<uint64_t>(shardSize, 1)), shardTimeout(shardTimeoutMs) {
+    listenFd = openShardSocket(address, true);
+    if (listenFd < 0) {
+        std::cerr << "Could not listen for evaluation workers on " << address << std::endl;
+    }
+}
+
+ShardedEvaluator::~ShardedEvaluator() {
+    for (Worker &worker : workers) {
+        sendShardMessage(worker.fd, ShardMessage::SHUTDOWN, {});
+        close(worker.fd);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        if (address.compare(0, 5, "unix:") == 0) {
+            unlink(address.substr(5).c_str());
+        }
+    }
+    for (int pid : localWorkerPids) {
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+bool ShardedEvaluator::isListening() const {
+    return listenFd >= 0;
+}
+
+size_t ShardedEvaluator::getNbWorkers() const {
+    return workers.size();
+}
+
+void ShardedEvaluator::spawnLocalWorkers(const std::string &executable, size_t nbWorkers,
+                                         const std::string &paramsPath) {
+    for (size_t i = 0; i < nbWorkers; i++) {
+        int pid = fork();
+        if (pid == 0) {
+            execl(executable.c_str(), executable.c_str(), address.c_str(), paramsPath.c_str(), (char *) nullptr);
+            std::cerr << "Could not start " << executable << std::endl;
+            _exit(127);
+        }
+        if (pid > 0) {
+            localWorkerPids.push_back(pid);
+        }
+    }
+}
+
+void ShardedEvaluator::acceptWorkers(int timeoutMs) {
+    if (listenFd < 0) {
+        return;
+    }
+    pollfd listening = {listenFd, POLLIN, 0};
+    while (poll(&listening, 1, timeoutMs) > 0 && (listening.revents & POLLIN)) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            break;
+        }
+        workers.push_back({fd});
+        // only wait for the first connection
+        timeoutMs = 0;
+    }
+}
+
+size_t ShardedEvaluator::waitForWorkers(size_t nbWorkers, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (workers.size() < nbWorkers && std::chrono::steady_clock::now() < deadline && listenFd >= 0) {
+        acceptWorkers(100);
+    }
+    return workers.size();
+}
+
+void ShardedEvaluator::dropWorker(size_t workerIdx, std::deque<size_t> &pending) {
+    Worker &worker = workers[workerIdx];
+    if (worker.busy) {
+        std::cerr << "Evaluation worker lost, its shard will be evaluated again." << std::endl;
+        pending.push_front(worker.shard);
+    }
+    close(worker.fd);
+    workers.erase(workers.begin() + workerIdx);
+}
+
+std::vector<double> ShardedEvaluator::evaluate(const std::vector<const TPG::TPGVertex *> &roots,
+                                               const std::vector<armlearn::Input<uint16_t> *> &goals,
+                                               Learn::LearningMode mode, uint64_t nbEpisodes, uint64_t maxNbActions,
+                                               uint64_t episodeLength,
+                                               const std::function<double(const TPG::TPGVertex &)> &localEvaluation) {
+    std::vector<double> scores(roots.size(), 0.0);
+
+    // Settings and goals, common to all shards
+    std::vector<uint8_t> header;
+    ByteWriter writer(header);
+    writer.writeVarUInt((uint64_t) mode);
+    writer.writeVarUInt(nbEpisodes);
+    writer.writeVarUInt(maxNbActions);
+    writer.writeVarUInt(episodeLength);
+    writer.writeVarUInt(goals.size());
+    for (auto goal : goals) {
+        for (int i = 0; i < 3; i++) {
+            writer.writeVarUInt(goal->getInput()[i]);
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> shardMessages;
+    std::vector<size_t> shardFirstRoot;
+    for (size_t first = 0; first < roots.size(); first += shardSize) {
+        size_t last = std::min<size_t>(first + shardSize, roots.size());
+        std::vector<uint8_t> message(header);
+        PolicyGraph::extract(std::vector<const TPG::TPGVertex *>(roots.begin() + first, roots.begin() + last))
+                .serialize(message);
+        shardMessages.push_back(std::move(message));
+        shardFirstRoot.push_back(first);
+    }
+    shardFirstRoot.push_back(roots.size());
+
+    std::deque<size_t> pending;
+    for (size_t shard = 0; shard < shardMessages.size(); shard++) {
+        pending.push_back(shard);
+    }
+
+    size_t nbDone = 0;
+    while (nbDone < shardMessages.size()) {
+        acceptWorkers(0);
+
+        if (workers.empty()) {
+            // No worker left, shards are evaluated locally
+            while (!pending.empty()) {
+                size_t shard = pending.front();
+                pending.pop_front();
+                for (size_t rootIdx = shardFirstRoot[shard]; rootIdx < shardFirstRoot[shard + 1]; rootIdx++) {
+                    scores[rootIdx] = localEvaluation(*roots[rootIdx]);
+                }
+                nbDone++;
+            }
+            continue;
+        }
+
+        // Give pending shards to idle workers
+        size_t workerIdx = 0;
+        while (workerIdx < workers.size() && !pending.empty()) {
+            if (workers[workerIdx].busy) {
+                workerIdx++;
+            } else if (sendShardMessage(workers[workerIdx].fd, ShardMessage::EVALUATE, shardMessages[pending.front()])) {
+                workers[workerIdx].busy = true;
+                workers[workerIdx].shard = pending.front();
+                workers[workerIdx].deadline = std::chrono::steady_clock::now() + shardTimeout;
+                pending.pop_front();
+                workerIdx++;
+            } else {
+                dropWorker(workerIdx, pending);
+            }
+        }
+
+        // Wait for results of busy workers
+        std::vector<pollfd> fds;
+        std::vector<size_t> busyWorkers;
+        for (workerIdx = 0; workerIdx < workers.size(); workerIdx++) {
+            if (workers[workerIdx].busy) {
+                fds.push_back({workers[workerIdx].fd, POLLIN, 0});
+                busyWorkers.push_back(workerIdx);
+            }
+        }
+        if (fds.empty()) {
+            continue;
+        }
+        int nbReady = poll(fds.data(), fds.size(), 100);
+        auto now = std::chrono::steady_clock::now();
+
+        // Backward, so that dropping a worker does not shift the ones left to process
+        for (size_t i = fds.size(); i-- > 0;) {
+            if (nbReady <= 0 || fds[i].revents == 0) {
+                // a worker that stays connected but never answers would keep its shard forever
+                if (now > workers[busyWorkers[i]].deadline) {
+                    std::cerr << "Evaluation worker timed out." << std::endl;
+                    dropWorker(busyWorkers[i], pending);
+                }
+                continue;
+            }
+            Worker &worker = workers[busyWorkers[i]];
+            size_t first = shardFirstRoot[worker.shard];
+            size_t last = shardFirstRoot[worker.shard + 1];
+
+            ShardMessage type;
+            std::vector<uint8_t> payload;
+            // the number of scores then the scores, or an error message
+            uint64_t maxSize = std::max<uint64_t>(10 + sizeof(double) * (last - first), SHARD_ERROR_MAX_SIZE);
+            bool received = receiveShardMessage(worker.fd, type, payload, maxSize);
+            bool valid = received && type == ShardMessage::RESULTS;
+            if (received && type == ShardMessage::ERROR) {
+                std::cerr << "Evaluation worker error: " << std::string(payload.begin(), payload.end()) << std::endl;
+            }
+            if (valid) {
+                try {
+                    ByteReader reader(payload.data(), payload.size());
+                    valid = (reader.readVarUInt() == last - first);
+                    for (size_t rootIdx = first; valid && rootIdx < last; rootIdx++) {
+                        scores[rootIdx] = reader.readDouble();
+                    }
+                } catch (std::runtime_error &) {
+                    valid = false;
+                }
+            }
+
+            if (valid) {
+                worker.busy = false;
+                nbDone++;
+            } else {
+                dropWorker(busyWorkers[i], pending);
+            }
+        }
+    }
+
+    return scores;
+}
+
+int runEvaluationWorker(const std::string &address, const Instructions::Set &set,
+                        const Learn::LearningParameters &params) {
+    // The coordinator may not listen yet
+    int fd = openShardSocket(address, false);
+    for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        fd = openShardSocket(address, false);
+    }
+    if (fd < 0) {
+        std::cerr << "Could not connect to the coordinator on " << address << std::endl;
+        return 1;
+    }
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    le.setDeterministicEvaluation(true);
+    le.targets.clear();
+
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+    TPG::TPGGraph tpg(env);
+    // No archive is updated, decisions and program results can always be reused
+    IncrementalExecutionEngine tee(env, 1 << 16);
+
+    int exitCode = 0;
+    ShardMessage type;
+    std::vector<uint8_t> payload;
+    while (receiveShardMessage(fd, type, payload) && type == ShardMessage::EVALUATE) {
+        std::vector<uint8_t> results;
+        try {
+            ByteReader reader(payload.data(), payload.size());
+            auto mode = (Learn::LearningMode) reader.readVarUInt();
+            uint64_t nbEpisodes = reader.readVarUInt();
+            uint64_t maxNbActions = reader.readVarUInt();
+            // cycle detection as configured on the coordinator
+            le.setEpisodeLength(reader.readVarUInt());
+
+            for (auto target : le.targets) {
+                delete target;
+            }
+            le.targets.clear();
+            uint64_t nbGoals = reader.readVarUInt();
+            for (uint64_t goal = 0; goal < nbGoals; goal++) {
+                uint16_t x = reader.readVarUInt();
+                uint16_t y = reader.readVarUInt();
+                uint16_t z = reader.readVarUInt();
+                le.targets.push_back(new armlearn::Input<uint16_t>({x, y, z}));
+            }
+
+            PolicyGraph policy = PolicyGraph::deserialize(reader);
+            tpg.clear();
+            // New roots may reuse the addresses of previous ones
+            tee.clearDecisions();
+            auto roots = policy.insertRootsInto(tpg);
+
+            ByteWriter writer(results);
+            writer.writeVarUInt(roots.size());
+            for (const TPG::TPGVertex *root : roots) {
+                double result = 0.0;
+                for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+                    result += ArmLearningAgent::runEpisode(tee, *root, episode, mode, le, maxNbActions);
+                }
+                writer.writeDouble(result / (double) nbEpisodes);
+            }
+        } catch (std::exception &e) {
+            // e.g. a malformed shard, or a bad_alloc while deserializing it
+            std::cerr << "Invalid shard: " << e.what() << std::endl;
+            std::string message = std::string(e.what()).substr(0, SHARD_ERROR_MAX_SIZE);
+            sendShardMessage(fd, ShardMessage::ERROR, std::vector<uint8_t>(message.begin(), message.end()));
+            exitCode = 1;
+            break;
+        }
+
+        if (!sendShardMessage(fd, ShardMessage::RESULTS, results)) {
+            break;
+        }
+    }
+
+    for (auto target : le.targets) {
+        delete target;
+    }
+    close(fd);
+    return exitCode;
+}
@@ -0,0 +1,159 @@
+#ifndef ARMGEGELATI_SHARDEDEVALUATION_H
+#define ARMGEGELATI_SHARDEDEVALUATION_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gegelati.h>
+#include <armlearn/input.h>
+
+/// Types of messages exchanged between the coordinator and evaluation workers
+enum class ShardMessage : uint8_t {
+    /// Coordinator to worker: goals, evaluation settings and a PolicyGraph of roots to evaluate
+    EVALUATE = 1,
+    /// Worker to coordinator: the average score of each root of the shard
+    RESULTS = 2,
+    /// Coordinator to worker: end of the training
+    SHUTDOWN = 3,
+    /// Worker to coordinator: the shard could not be evaluated, followed by the error message
+    ERROR = 4
+};
+
+/**
+* \brief Opens a stream socket.
+*
+* \param[in] address "tcp:host:port" or "unix:path".
+* \param[in] listening if true, the socket is bound and listens on the
+* address, otherwise it is connected to it.
+* \return the file descriptor of the socket, -1 on failure.
+*/
+int openShardSocket(const std::string &address, bool listening);
+
+/// Sends a message, returns false if the connection is lost
+bool sendShardMessage(int fd, ShardMessage type, const std::vector<uint8_t> &payload);
+
+/// Maximum size of the payload of a message
+#define SHARD_MESSAGE_MAX_SIZE ((uint64_t) 1 << 30)
+/// Maximum size of the message of an ERROR
+#define SHARD_ERROR_MAX_SIZE 256
+
+/**
+* \brief Receives a message.
+*
+* \param[in] maxSize maximum size of the payload, at most SHARD_MESSAGE_MAX_SIZE.
+* \return false if the connection is lost or if the peer announces a larger
+* payload, in which case the connection can not be used anymore.
+*/
+bool receiveShardMessage(int fd, ShardMessage &type, std::vector<uint8_t> &payload,
+                         uint64_t maxSize = SHARD_MESSAGE_MAX_SIZE);
+
+/**
+* \brief Coordinator side of the sharded evaluation of roots.
+*
+* Evaluation workers, possibly on other machines, connect to the address the
+* coordinator listens on. Roots to evaluate are split in shards of shardSize
+* roots, each sent to an idle worker as a serialized PolicyGraph along with the
+* current goals. A worker evaluates each root with one episode per goal, as
+* the ArmLearnWrapper in deterministic mode, and returns the average scores.
+*
+* Workers can join at any time. If a worker dies, sends an invalid answer or
+* does not answer within shardTimeout, its shard is given to another worker,
+* and if no worker is left, remaining shards are evaluated locally.
+*/
+class ShardedEvaluator {
+protected:
+    struct Worker {
+        int fd;
+        bool busy = false;
+        /// Shard being evaluated by a busy worker
+        size_t shard = 0;
+        /// Time after which a busy worker is considered hung
+        std::chrono::steady_clock::time_point deadline = {};
+    };
+
+    std::string address;
+
+    int listenFd;
+
+    uint64_t shardSize;
+
+    /// Maximum duration of the evaluation of a shard by a worker
+    std::chrono::milliseconds shardTimeout;
+
+    std::vector<Worker> workers;
+
+    /// Processes started by spawnLocalWorkers()
+    std::vector<int> localWorkerPids;
+
+    /// Accepts pending connections, waiting at most timeoutMs for a first one
+    void acceptWorkers(int timeoutMs);
+
+    /// Closes the connection with a worker, its shard, if any, goes back to pending
+    void dropWorker(size_t workerIdx, std::deque<size_t> &pending);
+
+public:
+    /**
+    * \brief Listens for evaluation workers on the address.
+    *
+    * \param[in] address see openShardSocket().
+    * \param[in] shardSize number of roots sent to a worker at once.
+    * \param[in] shardTimeoutMs maximum duration of the evaluation of a shard,
+    * after which the worker is dropped and the shard is evaluated again.
+    */
+    ShardedEvaluator(const std::string &address, uint64_t shardSize, uint64_t shardTimeoutMs = 600000);
+
+    /// Shuts down connected workers and waits for local ones
+    ~ShardedEvaluator();
+
+    /// Returns true if the coordinator listens on its address
+    bool isListening() const;
+
+    size_t getNbWorkers() const;
+
+    /**
+    * \brief Starts evaluation workers on this machine.
+    *
+    * \param[in] executable path of the evaluationWorker executable.
+    * \param[in] paramsPath params.json file given to workers.
+    */
+    void spawnLocalWorkers(const std::string &executable, size_t nbWorkers, const std::string &paramsPath);
+
+    /**
+    * \brief Waits until nbWorkers workers are connected, or timeoutMs elapsed.
+    *
+    * \return the number of connected workers.
+    */
+    size_t waitForWorkers(size_t nbWorkers, int timeoutMs);
+
+    /**
+    * \brief Evaluates roots on the workers.
+    *
+    * \param[in] episodeLength episode length of the cycle detection of the
+    * workers, 0 to disable it, see ArmLearnWrapper::setEpisodeLength().
+    * \param[in] localEvaluation function evaluating a root on the
+    * coordinator, used when no worker is connected.
+    * \return the average score of each root over nbEpisodes episodes.
+    */
+    std::vector<double> evaluate(const std::vector<const TPG::TPGVertex *> &roots,
+                                 const std::vector<armlearn::Input<uint16_t> *> &goals,
+                                 Learn::LearningMode mode, uint64_t nbEpisodes, uint64_t maxNbActions,
+                                 uint64_t episodeLength,
+                                 const std::function<double(const TPG::TPGVertex &)> &localEvaluation);
+};
+
+/**
+* \brief Worker side of the sharded evaluation.
+*
+* Connects to the coordinator and evaluates shards until it is shut down or
+* the connection is lost. The instruction set and parameters must be the same
+* as those of the coordinator.
+*
+* \return the exit code of the worker.
+*/
+int runEvaluationWorker(const std::string &address, const Instructions::Set &set,
+                        const Learn::LearningParameters &params);
+
+#endif //ARMGEGELATI_SHARDEDEVALUATION_H
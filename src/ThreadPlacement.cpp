@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "ThreadPlacement.h"
+
+ThreadPlacement::ThreadPlacement(const std::vector<int> &allowedCpus, bool scatter) {
+    std::vector<int> candidates = allowedCpus.empty() ? getAvailableCpus() : allowedCpus;
+
+    std::map<int, std::vector<int>> cpusPerNode;
+    for (int cpu : candidates) {
+        cpusPerNode[getNumaNodeOfCpu(cpu)].push_back(cpu);
+    }
+
+    if (scatter) {
+        // round robin over nodes
+        bool remaining = true;
+        for (size_t rank = 0; remaining; rank++) {
+            remaining = false;
+            for (auto &node : cpusPerNode) {
+                if (rank < node.second.size()) {
+                    cpus.push_back(node.second[rank]);
+                    nodes.push_back(node.first);
+                    remaining = true;
+                }
+            }
+        }
+    } else {
+        for (auto &node : cpusPerNode) {
+            for (int cpu : node.second) {
+                cpus.push_back(cpu);
+                nodes.push_back(node.first);
+            }
+        }
+    }
+}
+
+bool ThreadPlacement::isEnabled() const {
+    return !cpus.empty();
+}
+
+size_t ThreadPlacement::getNbCpus() const {
+    return cpus.size();
+}
+
+int ThreadPlacement::getCpu(size_t workerIdx) const {
+    return isEnabled() ? cpus[workerIdx % cpus.size()] : -1;
+}
+
+int ThreadPlacement::getNumaNode(size_t workerIdx) const {
+    return isEnabled() ? nodes[workerIdx % nodes.size()] : -1;
+}
+
+bool ThreadPlacement::pinCurrentThread(size_t workerIdx) const {
+    if (!isEnabled() || !isValidCpu(getCpu(workerIdx))) {
+        return false;
+    }
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(getCpu(workerIdx), &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) != 0) {
+        return false;
+    }
+    // make sure the thread runs on its cpu before it allocates anything
+    std::this_thread::yield();
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string ThreadPlacement::toString(size_t nbWorkers) const {
+    std::stringstream res;
+    for (size_t workerIdx = 0; workerIdx < nbWorkers; workerIdx++) {
+        res << "worker " << workerIdx << " : cpu " << getCpu(workerIdx) << " ; node " << getNumaNode(workerIdx)
+            << std::endl;
+    }
+    return res.str();
+}
+
+bool ThreadPlacement::isValidCpu(int cpu) {
+#ifdef __linux__
+    return cpu >= 0 && cpu < CPU_SETSIZE;
+#else
+    return cpu >= 0;
+#endif
+}
+
+std::vector<int> ThreadPlacement::getAvailableCpus() {
+    std::vector<int> result;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuSet) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                result.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (result.empty()) {
+        for (unsigned int cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+            result.push_back((int) cpu);
+        }
+    }
+    return result;
+}
+
+int ThreadPlacement::getNumaNodeOfCpu(int cpu) {
+#ifdef __linux__
+    // sysfs lists a "nodeN" entry in the directory of each cpu
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return 0;
+    }
+    int node = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name(entry->d_name);
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            node = std::stoi(name.substr(4));
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,73 @@
+#ifndef ARMGEGELATI_THREADPLACEMENT_H
+#define ARMGEGELATI_THREADPLACEMENT_H
+
+#include <string>
+#include <vector>
+
+/**
+* \brief Placement of evaluation threads on cpus.
+*
+* Each worker is pinned on a cpu, cpus being ordered by NUMA node. Once a
+* worker is pinned, memory it allocates and touches first (its environment
+* clone, data handlers and execution engine) is placed by the kernel on the
+* NUMA node of its cpu.
+*
+* Pinning is only supported on Linux, elsewhere workers are left unpinned.
+*/
+class ThreadPlacement {
+protected:
+    /// Cpu of each worker, workers beyond its size wrap around
+    std::vector<int> cpus;
+
+    /// NUMA node of each cpu in cpus
+    std::vector<int> nodes;
+
+public:
+    /**
+    * \brief Placement leaving threads unpinned.
+    */
+    ThreadPlacement() = default;
+
+    /**
+    * \brief Placement pinning workers on the given cpus.
+    *
+    * \param[in] allowedCpus cpus to use, all cpus available to the process if empty.
+    * \param[in] scatter if true, consecutive workers are spread over NUMA
+    * nodes, otherwise a node is filled before using the next one.
+    */
+    explicit ThreadPlacement(const std::vector<int> &allowedCpus, bool scatter = false);
+
+    /// Returns true if workers are pinned
+    bool isEnabled() const;
+
+    /// Number of cpus of the placement, 0 if workers are not pinned
+    size_t getNbCpus() const;
+
+    /// Cpu of a worker, -1 if workers are not pinned
+    int getCpu(size_t workerIdx) const;
+
+    /// NUMA node of a worker, -1 if workers are not pinned
+    int getNumaNode(size_t workerIdx) const;
+
+    /**
+    * \brief Pins the calling thread on the cpu of the worker.
+    *
+    * Must be called by the worker before allocating its data.
+    * \return false if the thread could not be pinned.
+    */
+    bool pinCurrentThread(size_t workerIdx) const;
+
+    /// Returns a description of the cpu and node of each worker
+    std::string toString(size_t nbWorkers) const;
+
+    /// Cpus on which the process is allowed to run
+    static std::vector<int> getAvailableCpus();
+
+    /// Returns true if a thread can be pinned on the cpu id, i.e. it fits in a cpu_set_t
+    static bool isValidCpu(int cpu);
+
+    /// NUMA node of a cpu, 0 if it cannot be determined
+    static int getNumaNodeOfCpu(int cpu);
+};
+
+#endif //ARMGEGELATI_THREADPLACEMENT_H
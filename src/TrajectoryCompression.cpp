@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "TrajectoryCompression.h"
+
+std::vector<std::vector<uint16_t>> recordPolicyPositions(const TPG::TPGVertex &root, TPG::TPGExecutionEngine &tee,
+                                                         ArmLearnWrapper &le, uint64_t nbSteps) {
+    std::vector<std::vector<uint16_t>> positions;
+    double observation[ARM_OBSERVATION_SIZE];
+    for (uint64_t step = 0; step <= nbSteps; step++) {
+        le.copyObservation(observation);
+        // motorPos follows cartesianDif
+        positions.emplace_back(observation + 3, observation + ARM_OBSERVATION_SIZE);
+        if (step == nbSteps || le.isTerminal()) {
+            break;
+        }
+        le.doAction(((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID());
+    }
+    return positions;
+}
+
+/// Euclidean distance from point to the segment [start, end]
+static double distanceToSegment(const std::vector<uint16_t> &point, const std::vector<uint16_t> &start,
+                                const std::vector<uint16_t> &end) {
+    double squaredLength = 0.0;
+    double dot = 0.0;
+    for (size_t i = 0; i < point.size(); i++) {
+        double direction = (double) end[i] - (double) start[i];
+        squaredLength += direction * direction;
+        dot += ((double) point[i] - (double) start[i]) * direction;
+    }
+    double t = (squaredLength > 0.0) ? std::min(1.0, std::max(0.0, dot / squaredLength)) : 0.0;
+
+    double squaredDistance = 0.0;
+    for (size_t i = 0; i < point.size(); i++) {
+        double projected = (double) start[i] + t * ((double) end[i] - (double) start[i]);
+        squaredDistance += ((double) point[i] - projected) * ((double) point[i] - projected);
+    }
+    return std::sqrt(squaredDistance);
+}
+
+std::vector<std::vector<uint16_t>> compressTrajectory(const std::vector<std::vector<uint16_t>> &positions,
+                                                      double tolerance) {
+    std::vector<std::vector<uint16_t>> points;
+    for (const auto &position : positions) {
+        if (points.empty() || position != points.back()) {
+            points.push_back(position);
+        }
+    }
+    if (points.size() < 3) {
+        return points;
+    }
+
+    // Segments still to simplify, without recursion on long trajectories
+    std::vector<bool> kept(points.size(), false);
+    kept.front() = true;
+    kept.back() = true;
+    std::vector<std::pair<size_t, size_t>> segments = {{0, points.size() - 1}};
+    while (!segments.empty()) {
+        size_t first = segments.back().first;
+        size_t last = segments.back().second;
+        segments.pop_back();
+
+        double maxDistance = -1.0;
+        size_t farthest = first;
+        for (size_t i = first + 1; i < last; i++) {
+            double distance = distanceToSegment(points[i], points[first], points[last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+        if (maxDistance > tolerance) {
+            kept[farthest] = true;
+            segments.emplace_back(first, farthest);
+            segments.emplace_back(farthest, last);
+        }
+    }
+
+    std::vector<std::vector<uint16_t>> waypoints;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (kept[i]) {
+            waypoints.push_back(points[i]);
+        }
+    }
+    return waypoints;
+}
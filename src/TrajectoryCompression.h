@@ -0,0 +1,36 @@
+#ifndef ARMGEGELATI_TRAJECTORYCOMPRESSION_H
+#define ARMGEGELATI_TRAJECTORYCOMPRESSION_H
+
+#include <cstdint>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "ArmLearnWrapper.h"
+
+/**
+* \brief Servo positions visited by a root, in simulation.
+*
+* The root is executed from the current state of the environment until the
+* episode ends or nbSteps actions were done. The first position is the
+* initial one.
+*/
+std::vector<std::vector<uint16_t>> recordPolicyPositions(const TPG::TPGVertex &root, TPG::TPGExecutionEngine &tee,
+                                                         ArmLearnWrapper &le, uint64_t nbSteps);
+
+/**
+* \brief Keeps the fewest waypoints of a sequence of servo positions, within a tolerance.
+*
+* Ramer-Douglas-Peucker simplification in joint space: a position is dropped
+* when its euclidean distance, in servo units, to the segment between the
+* kept positions around it is at most the tolerance. The first and last
+* positions are always kept, and consecutive duplicates are removed.
+*
+* Policies move one servo by one degree per action, so most of their
+* positions lie on straight multi-joint segments that a few waypoints
+* describe.
+*/
+std::vector<std::vector<uint16_t>> compressTrajectory(const std::vector<std::vector<uint16_t>> &positions,
+                                                      double tolerance);
+
+#endif //ARMGEGELATI_TRAJECTORYCOMPRESSION_H
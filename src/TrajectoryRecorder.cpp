@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TrajectoryRecorder.h"
+
+// Number of records by which append-only files grow
+#define TRAJECTORY_CHUNK (1 << 14)
+
+static const char TRAJECTORY_MAGIC[8] = "ARMTRAJ";
+
+static_assert(sizeof(TrajectoryFileHeader) == 128, "Records must stay aligned on cache lines");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Counters are shared through the mapped file");
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string &path, uint64_t capacity, bool ring) {
+    if (capacity == 0) {
+        throw std::runtime_error("A trajectory file needs a capacity.");
+    }
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not create " + path);
+    }
+
+    mappingSize = sizeof(TrajectoryFileHeader) + capacity * sizeof(TrajectoryRecord);
+    size_t fileSize = ring ? mappingSize
+                           : sizeof(TrajectoryFileHeader)
+                             + std::min<uint64_t>(capacity, TRAJECTORY_CHUNK) * sizeof(TrajectoryRecord);
+    // Pages of the mapping above the end of the file are only touched once the file grew
+    if (ftruncate(fd, fileSize) != 0 ||
+        (mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        mapping = nullptr;
+        close(fd);
+        throw std::runtime_error("Could not map " + path);
+    }
+
+    header = (TrajectoryFileHeader *) mapping;
+    records = (TrajectoryRecord *) ((char *) mapping + sizeof(TrajectoryFileHeader));
+    std::memcpy(header->magic, TRAJECTORY_MAGIC, sizeof(header->magic));
+    header->version = 1;
+    header->recordSize = sizeof(TrajectoryRecord);
+    header->capacity = capacity;
+    header->ring = ring ? 1 : 0;
+    header->nbRecords.store(0);
+    header->nbEpisodes.store(0);
+    header->fileSize.store(fileSize);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+uint64_t TrajectoryRecorder::newEpisode() {
+    return header->nbEpisodes.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TrajectoryRecorder::growFile(uint64_t recordIdx) {
+    uint64_t end = sizeof(TrajectoryFileHeader) + (recordIdx + 1) * sizeof(TrajectoryRecord);
+    uint64_t fileSize = header->fileSize.load(std::memory_order_acquire);
+    if (end <= fileSize) {
+        return true;
+    }
+
+    uint64_t nbChunks = (recordIdx + TRAJECTORY_CHUNK) / TRAJECTORY_CHUNK;
+    uint64_t newSize = std::min<uint64_t>(mappingSize, sizeof(TrajectoryFileHeader)
+                                                       + nbChunks * TRAJECTORY_CHUNK * sizeof(TrajectoryRecord));
+    // Unlike ftruncate, concurrent calls never shrink the file
+    if (posix_fallocate(fd, 0, newSize) != 0) {
+        return false;
+    }
+    while (fileSize < newSize && !header->fileSize.compare_exchange_weak(fileSize, newSize)) {
+    }
+    return true;
+}
+
+void TrajectoryRecorder::record(const TrajectoryRecord &record) {
+    uint64_t recordIdx = header->nbRecords.fetch_add(1, std::memory_order_relaxed);
+    if (header->ring) {
+        recordIdx %= header->capacity;
+    } else if (recordIdx >= header->capacity || !growFile(recordIdx)) {
+        return;
+    }
+    records[recordIdx] = record;
+}
+
+uint64_t TrajectoryRecorder::getNbRecords() const {
+    return header->nbRecords.load();
+}
+
+TrajectoryReader::TrajectoryReader(const std::string &path) {
+    fd = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    mappingSize = status.st_size;
+    if (mappingSize < sizeof(TrajectoryFileHeader) ||
+        (mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        mapping = nullptr;
+        close(fd);
+        throw std::runtime_error(path + " is not a trajectory file.");
+    }
+
+    header = (const TrajectoryFileHeader *) mapping;
+    if (std::memcmp(header->magic, TRAJECTORY_MAGIC, sizeof(header->magic)) != 0 || header->version != 1
+        || header->recordSize != sizeof(TrajectoryRecord)) {
+        munmap(mapping, mappingSize);
+        close(fd);
+        throw std::runtime_error(path + " is not a trajectory file.");
+    }
+    records = (const TrajectoryRecord *) ((const char *) mapping + sizeof(TrajectoryFileHeader));
+
+    uint64_t nbWritten = header->nbRecords.load();
+    uint64_t nbInFile = (mappingSize - sizeof(TrajectoryFileHeader)) / sizeof(TrajectoryRecord);
+    nbRecords = std::min(std::min(nbWritten, header->capacity), nbInFile);
+    if (header->ring && nbWritten > header->capacity) {
+        firstRecord = nbWritten % header->capacity;
+    }
+}
+
+TrajectoryReader::~TrajectoryReader() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+uint64_t TrajectoryReader::getNbRecords() const {
+    return nbRecords;
+}
+
+const TrajectoryRecord &TrajectoryReader::getRecord(uint64_t i) const {
+    return records[(firstRecord + i) % header->capacity];
+}
@@ -0,0 +1,161 @@
+#ifndef ARMGEGELATI_TRAJECTORYRECORDER_H
+#define ARMGEGELATI_TRAJECTORYRECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+* \brief Step of an episode of the ArmLearnWrapper, as stored in a trajectory file.
+*
+* The state is the one in which the action was taken, the reward the one
+* obtained after it. The state reached by the action is the state of the next
+* step of the same episode.
+*/
+struct TrajectoryRecord {
+    /// Identifier of the episode, unique in a trajectory file
+    uint64_t episode;
+
+    /// Number of actions done in the episode before this one
+    uint64_t step;
+
+    uint64_t action;
+
+    double motorPos[6];
+
+    double cartesianPos[3];
+
+    double goal[3];
+
+    double reward;
+};
+
+/**
+* \brief Header of a trajectory file, followed by the records.
+*
+* Counters are updated atomically in the mapped file, so that threads and
+* forked processes can record in the same file.
+*/
+struct TrajectoryFileHeader {
+    char magic[8];
+
+    uint32_t version;
+
+    /// sizeof(TrajectoryRecord)
+    uint32_t recordSize;
+
+    /// Maximum number of records in the file
+    uint64_t capacity;
+
+    /// 1 if records overwrite the oldest ones once the capacity is reached
+    uint64_t ring;
+
+    /// Number of records written since the creation of the file
+    std::atomic<uint64_t> nbRecords;
+
+    /// Number of episode identifiers given
+    std::atomic<uint64_t> nbEpisodes;
+
+    /// Size of the file, grown by chunks of records in append-only mode
+    std::atomic<uint64_t> fileSize;
+
+    uint8_t padding[72];
+};
+
+/**
+* \brief Appends TrajectoryRecord to a memory-mapped file.
+*
+* The whole capacity of the file is mapped at construction, so recording a
+* step is an atomic increment and a copy of the record, without system call
+* or text formatting. In ring mode, the file has its full size from the start
+* and new records overwrite the oldest ones. In append-only mode, the file
+* grows by chunks of records, and records above the capacity are dropped.
+*
+* A recorder can be shared by all the threads of a process, and by processes
+* forked after its construction.
+*/
+class TrajectoryRecorder {
+protected:
+    int fd = -1;
+
+    /// Mapping of the whole capacity of the file
+    void *mapping = nullptr;
+
+    size_t mappingSize = 0;
+
+    TrajectoryFileHeader *header = nullptr;
+
+    TrajectoryRecord *records = nullptr;
+
+    /// Makes the file large enough to hold the record of the given index, false if the disk is full
+    bool growFile(uint64_t recordIdx);
+
+public:
+    /**
+    * \brief Creates the trajectory file, replacing any existing one.
+    *
+    * Throws std::runtime_error if the file can not be created or mapped.
+    *
+    * \param[in] capacity maximum number of records of the file.
+    * \param[in] ring true to overwrite the oldest records once the file is full.
+    */
+    TrajectoryRecorder(const std::string &path, uint64_t capacity, bool ring);
+
+    /// Unmaps and closes the file
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder &) = delete;
+
+    TrajectoryRecorder &operator=(const TrajectoryRecorder &) = delete;
+
+    /// Returns a new episode identifier
+    uint64_t newEpisode();
+
+    /// Stores a record, dropped if the append-only file is full or can not grow
+    void record(const TrajectoryRecord &record);
+
+    /// Number of records written, including overwritten and dropped ones
+    uint64_t getNbRecords() const;
+};
+
+/**
+* \brief Reads a trajectory file written by a TrajectoryRecorder.
+*
+* The file is mapped read-only, and records are given from the oldest to the
+* newest one.
+*/
+class TrajectoryReader {
+protected:
+    int fd = -1;
+
+    void *mapping = nullptr;
+
+    size_t mappingSize = 0;
+
+    const TrajectoryFileHeader *header = nullptr;
+
+    const TrajectoryRecord *records = nullptr;
+
+    uint64_t nbRecords = 0;
+
+    /// Index in records of the oldest record
+    uint64_t firstRecord = 0;
+
+public:
+    /// Maps the file, throws std::runtime_error if it is not a trajectory file
+    explicit TrajectoryReader(const std::string &path);
+
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader &) = delete;
+
+    TrajectoryReader &operator=(const TrajectoryReader &) = delete;
+
+    /// Number of records available
+    uint64_t getNbRecords() const;
+
+    /// Record i, from the oldest one
+    const TrajectoryRecord &getRecord(uint64_t i) const;
+};
+
+#endif //ARMGEGELATI_TRAJECTORYRECORDER_H
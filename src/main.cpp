@@ -4,7 +4,13 @@
 
 #include <gegelati.h>
 
+#include "ArmInstructions.h"
 #include "ArmLearnWrapper.h"
+#include "ArmLearningAgent.h"
+#include "ArmLearnParameters.h"
+#include "IslandModel.h"
+#include "PolicyExport.h"
+#include "ShardedEvaluation.h"
 #include "resultTester.h"
 
 #ifndef NB_GENERATIONS
@@ -20,23 +26,15 @@ int main() {
         return 0;
     }
 
+    // Loads parameters specific to the wrapper from "params.json" file
+    ArmLearnParameters armParams;
+    if (!loadArmLearnParametersFromJson("../../params.json", armParams)) {
+        return 1;
+    }
+
     // Create the instruction set for programs
     Instructions::Set set;
-    auto minus = [](double a, double b) -> double { return a - b; };
-    auto add = [](double a, double b) -> double { return a + b; };
-    auto times = [](double a, double b) -> double { return a * b; };
-    auto divide = [](double a, double b) -> double { return a / b; };
-    auto cond = [](double a, double b) -> double { return a < b ? -a : a; };
-    auto cos = [](double a) -> double { return std::cos(a); };
-    auto sin = [](double a) -> double { return std::sin(a); };
-
-    set.add(*(new Instructions::LambdaInstruction<double, double>(minus)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(add)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(times)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(divide)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(cond)));
-    set.add(*(new Instructions::LambdaInstruction<double>(cos)));
-    set.add(*(new Instructions::LambdaInstruction<double>(sin)));
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
 
 
 
@@ -47,15 +45,61 @@ int main() {
     Learn::LearningParameters params;
     File::ParametersParser::loadParametersFromJson("../../params.json", params);
 
+    // Records the steps of the episodes of training, read with trajectoryToCsv
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (!armParams.trajectoryFile.empty()) {
+        recorder.reset(new TrajectoryRecorder(armParams.trajectoryFile, armParams.trajectoryCapacity,
+                                              armParams.trajectoryRing));
+    }
+
+    // Island mode: several populations trained in parallel, exchanging their best roots
+    if (armParams.nbIslands > 1) {
+        IslandModel islands(set, params, armParams);
+        islands.setRecorder(recorder.get());
+        islands.train(NB_GENERATIONS);
+
+        // Keep best policy
+        ArmLearningAgent &bestIsland = islands.getBestIsland();
+        bestIsland.keepBestPolicy();
+        File::TPGGraphDotExporter dotExporter("out_best.dot", bestIsland.getTPGGraph());
+        dotExporter.print();
+        // Minimal graph for deployment
+        exportCompactPolicy(*bestIsland.getBestRoot().first, bestIsland.getTPGGraph().getEnvironment(),
+                            islands.getWrapper(islands.getBestIslandIdx()), "out_best_compact.dot");
+
+        // cleanup
+        for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+            delete (&set.getInstruction(i));
+        }
+        return 0;
+    }
+
     int i=0;
 
     // Instantiate the LearningEnvironment
     ArmLearnWrapper le(&i);
+    // The simulator is deterministic, one pass over the goals is enough to evaluate a root
+    le.setDeterministicEvaluation(armParams.deterministicEvaluation);
+    le.setRecorder(recorder.get());
 
     // Instantiate and init the learning agent
-    Learn::ParallelLearningAgent la(le, set, params);
+    ArmLearningAgent la(le, set, params);
+    // Evaluation options: intra-root parallelism, scheduler and thread placement
+    la.setParameters(armParams);
     la.init();
 
+    // Sharded evaluation: roots are evaluated by evaluation workers connected to this process
+    std::unique_ptr<ShardedEvaluator> shardedEvaluator;
+    if (!armParams.shardAddress.empty()) {
+        shardedEvaluator.reset(new ShardedEvaluator(armParams.shardAddress, armParams.shardSize,
+                                                     armParams.shardTimeout * 1000));
+        shardedEvaluator->spawnLocalWorkers("./evaluationWorker", armParams.nbLocalShardWorkers, "../../params.json");
+        size_t nbWorkers = shardedEvaluator->waitForWorkers(
+                armParams.nbLocalShardWorkers + armParams.nbShardWorkers, 60000);
+        std::cout << nbWorkers << " evaluation workers connected on " << armParams.shardAddress << std::endl;
+        la.setShardedEvaluator(shardedEvaluator.get());
+    }
+
     // Adds a logger to the LA (to get statistics on learning) on std::cout
     /*auto logCout = *new Log::LABasicLogger();
     la.addLogger(logCout);*/
@@ -64,6 +108,14 @@ int main() {
     std::ofstream o("log");
     auto logFile = *new Log::LABasicLogger(la,o);
 
+    // Logs busy and idle times of evaluation threads during training
+    std::ofstream workersLog("workers.log");
+    workersLog << "Gen\tThread\tBusy\tIdle\tNbJobs\tNbStolen" << std::endl;
+
+    // Logs the fraction of root evaluations saved by behavioural deduplication
+    std::ofstream deduplicationLog("deduplication.log");
+    deduplicationLog << "Gen\tSaved" << std::endl;
+
     // Create an exporter for all graphs
     File::TPGGraphDotExporter dotExporter("out_000.dot", la.getTPGGraph());
 
@@ -92,6 +144,12 @@ int main() {
 
         la.trainOneGeneration(i);
 
+        auto workerStats = la.getWorkerStats();
+        for (size_t w = 0; w < workerStats.size(); w++) {
+            workersLog << i << "\t" << w << "\t" << workerStats[w].busyTime << "\t" << workerStats[w].idleTime
+                       << "\t" << workerStats[w].nbJobs << "\t" << workerStats[w].nbStolenJobs << std::endl;
+        }
+        deduplicationLog << i << "\t" << la.getDeduplicationRatio() << std::endl;
 
         // loads the validation goal to get learning stats, but don't worry randomGoal will be re-loaded later
         le.targets.clear();
@@ -122,6 +180,8 @@ int main() {
     la.keepBestPolicy();
     dotExporter.setNewFilePath("out_best.dot");
     dotExporter.print();
+    // Minimal graph for deployment
+    exportCompactPolicy(*la.getBestRoot().first, la.getTPGGraph().getEnvironment(), le, "out_best_compact.dot");
 
 
 
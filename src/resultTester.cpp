@@ -4,30 +4,24 @@
 #include <string>
 #include <cfloat>
 #include <inttypes.h>
+#include <memory>
 
 #include <gegelati.h>
 #include "resultTester.h"
 
+#include "ArmInstructions.h"
+#include "ArmLearnParameters.h"
 #include "ArmLearnWrapper.h"
+#include "IncrementalExecutionEngine.h"
+#include "PolicyGraph.h"
 
 int agentTest() {
     // Create the instruction set for programs
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
     Instructions::Set set;
-    auto minus = [](double a, double b) -> double { return a - b; };
-    auto add = [](double a, double b) -> double { return a + b; };
-    auto times = [](double a, double b) -> double { return a * b; };
-    auto divide = [](double a, double b) -> double { return a / b; };
-    auto cond = [](double a, double b) -> double { return a < b ? -a : a; };
-    auto cos = [](double a) -> double { return std::cos(a); };
-    auto sin = [](double a) -> double { return std::sin(a); };
-
-    set.add(*(new Instructions::LambdaInstruction<double, double>(minus)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(add)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(times)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(divide)));
-    set.add(*(new Instructions::LambdaInstruction<double, double>(cond)));
-    set.add(*(new Instructions::LambdaInstruction<double>(cos)));
-    set.add(*(new Instructions::LambdaInstruction<double>(sin)));
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
 
 
     int i=-1;
@@ -43,7 +37,8 @@ int agentTest() {
     auto tpg = TPG::TPGGraph(env);
 
     // Instantiate the tee that will handle the decisions taken by the TPG
-    TPG::TPGExecutionEngine tee(env);
+    // (programs whose inputs did not change since the last step are not executed again)
+    IncrementalExecutionEngine tee(env);
 
 
 
@@ -52,14 +47,26 @@ int agentTest() {
     dotImporter.importGraph();
 
     // takes the first root of the graph, anyway out_best has only 1 root (the best)
-    auto root = tpg.getRootVertices().front();
+    // and keeps a compacted copy of it, which takes the same decisions with fewer program lines
+    PolicyGraph policy = PolicyGraph::extract(*tpg.getRootVertices().front());
+    policy.compact(env);
+    auto compactTpg = TPG::TPGGraph(env);
+    auto root = &policy.insertInto(compactTpg);
 
     // make a try on a random position
 
 
     //runByHand(root, tee, le, validationGoal);
 
+    // Steps of the evaluations, read with trajectoryToCsv, when a trajectory file is set
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (!armParams.trajectoryFile.empty()) {
+        recorder.reset(new TrajectoryRecorder(armParams.trajectoryFile, armParams.trajectoryCapacity,
+                                              armParams.trajectoryRing));
+    }
+    le.setRecorder(recorder.get());
     runEvals(root,tee,le);
+    le.setRecorder(nullptr);
 
     // cleanup
     for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
@@ -89,6 +96,7 @@ int runByHand(const TPG::TPGVertex* root, TPG::TPGExecutionEngine& tee, ArmLearn
 
 int runEvals(const TPG::TPGVertex* root, TPG::TPGExecutionEngine& tee, ArmLearnWrapper& le){
     std::cout<<"begining of runEvals"<<std::endl;
+    auto incrementalTee = dynamic_cast<IncrementalExecutionEngine *>(&tee);
     double x=1;
     while(x!=1000){
         auto rnd = le.randomGoal();
@@ -96,7 +104,8 @@ int runEvals(const TPG::TPGVertex* root, TPG::TPGExecutionEngine& tee, ArmLearnW
         le.reset();
         for(int i=0; i<1000; i++) {
             // gets the action the TPG would decide in this situation (the result can only be between 0 and 8 included)
-            uint64_t action = ((const TPG::TPGAction *) tee.executeFromRoot(*root).back())->getActionID();
+            uint64_t action = (incrementalTee != nullptr) ? incrementalTee->executeDecision(*root, le)
+                                                          : ((const TPG::TPGAction *) tee.executeFromRoot(*root).back())->getActionID();
             le.doAction(action);
 
             // prints the game board
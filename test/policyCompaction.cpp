@@ -0,0 +1,121 @@
+/**
+* Test of the compaction of policies, see PolicyGraph::compact() and
+* exportCompactPolicy().
+*
+* Random graphs are created and mutated by a LearningAgent over a few
+* generations, and graphs can also be imported from dot files. The policy of
+* each root is extracted, compacted and inserted in a new graph, and must take
+* the same action as the original root on each observation recorded from the
+* ArmLearnWrapper by an ObservationProbe.
+*
+* Usage: policyCompaction params.json [policy.dot ...]
+* Returns 0 if all compacted policies take the same actions.
+*/
+#include <iostream>
+#include <vector>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/ObservationProbe.h"
+#include "../src/PolicyGraph.h"
+
+// Number of seeds of random graphs
+#define NB_RANDOM_GRAPHS 3
+// Number of generations mutating each random graph
+#define NB_GENERATIONS 5
+// Number of observations on which the actions of a policy are compared
+#define NB_OBSERVATIONS 500
+
+/// Compacts the policy of each root of the graph, returns the number of policies taking other actions
+static uint64_t checkCompaction(const TPG::TPGGraph &graph, const Environment &env, ObservationProbe &probe) {
+    uint64_t nbErrors = 0;
+    for (const TPG::TPGVertex *root : graph.getRootVertices()) {
+        PolicyGraph policy = PolicyGraph::extract(*root);
+        PolicyGraph compacted = policy;
+        compacted.compact(env);
+
+        TPG::TPGGraph originalGraph(env);
+        const TPG::TPGVertex &originalRoot = policy.insertInto(originalGraph);
+        TPG::TPGGraph compactGraph(env);
+        const TPG::TPGVertex &compactRoot = compacted.insertInto(compactGraph);
+
+        auto expected = probe.getActionSignature(originalRoot);
+        auto actions = probe.getActionSignature(compactRoot);
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (actions[i] != expected[i]) {
+                std::cerr << "Observation " << i << ": action " << actions[i] << " instead of " << expected[i]
+                          << " after compaction (" << policy.getNbLines() << " -> " << compacted.getNbLines()
+                          << " lines)" << std::endl;
+                nbErrors++;
+                break;
+            }
+        }
+    }
+    return nbErrors;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " params.json [policy.dot ...]" << std::endl;
+        return 1;
+    }
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson(argv[1], armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson(argv[1], params);
+    // Short evaluations, only the mutations of the graph matter
+    params.maxNbActionsPerEval = 10;
+    params.nbIterationsPerPolicyEvaluation = 1;
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    le.targets.clear();
+    for (int j = 0; j < 10; j++) {
+        le.targets.emplace_back(le.randomGoal());
+    }
+    le.setDeterministicEvaluation(true);
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+
+    ObservationProbe probe(set, params.nbRegisters);
+    probe.record(le, NB_OBSERVATIONS, 0);
+
+    uint64_t nbPolicies = 0;
+    uint64_t nbErrors = 0;
+    for (uint64_t seed = 0; seed < NB_RANDOM_GRAPHS; seed++) {
+        Learn::LearningAgent la(le, set, params);
+        la.init(seed);
+        for (uint64_t generation = 0; generation < NB_GENERATIONS; generation++) {
+            la.trainOneGeneration(generation);
+        }
+        nbPolicies += la.getTPGGraph().getNbRootVertices();
+        nbErrors += checkCompaction(la.getTPGGraph(), env, probe);
+    }
+
+    for (int arg = 2; arg < argc; arg++) {
+        TPG::TPGGraph graph(env);
+        File::TPGGraphDotImporter dotImporter(argv[arg], env, graph);
+        dotImporter.importGraph();
+        nbPolicies += graph.getNbRootVertices();
+        nbErrors += checkCompaction(graph, env, probe);
+    }
+
+    std::cout << nbPolicies - nbErrors << "/" << nbPolicies << " compacted policies take the same actions on "
+              << probe.getNbObservations() << " observations" << std::endl;
+
+    for (auto target : le.targets) {
+        delete target;
+    }
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return (nbErrors == 0 && nbPolicies > 0) ? 0 : 1;
+}
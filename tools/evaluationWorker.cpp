@@ -0,0 +1,50 @@
+/**
+* Evaluation worker of the sharded evaluation.
+*
+* Connects to an armGegelati process whose "shardAddress" parameter is set,
+* and evaluates the roots it receives until the training ends. Workers can be
+* started on any machine reaching the address, before or during the training.
+*
+* Usage: evaluationWorker address [params.json]
+* where address is "tcp:host:port" or "unix:path".
+*/
+#include <cmath>
+#include <iostream>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ShardedEvaluation.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " address [params.json]" << std::endl;
+        return 1;
+    }
+
+    // Create the instruction set for programs, identical to the one of armGegelati
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson(argc > 2 ? argv[2] : "../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    // The number of registers must match the one of the coordinator
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson(argc > 2 ? argv[2] : "../../params.json", params);
+
+    int result = 1;
+    try {
+        result = runEvaluationWorker(argv[1], set, params);
+    } catch (const std::exception &e) {
+        std::cerr << "Evaluation worker stopped: " << e.what() << std::endl;
+    }
+
+    // cleanup
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return result;
+}
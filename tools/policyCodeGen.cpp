@@ -0,0 +1,71 @@
+/**
+* Generates the C source of a trained policy, see generatePolicyC().
+*
+* The first root of the dot graph is extracted and compacted before the
+* generation, so the generated code only contains instructions that
+* influence its decisions.
+*
+* Usage: policyCodeGen policy.dot output.c [params.json]
+*/
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/PolicyCodeGenerator.h"
+#include "../src/PolicyGraph.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " policy.dot output.c [params.json]" << std::endl;
+        return 1;
+    }
+
+    // Create the instruction set for programs, identical to the one of armGegelati
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson(argc > 3 ? argv[3] : "../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson(argc > 3 ? argv[3] : "../../params.json", params);
+
+    // The wrapper provides data sources with the layout of the trained graph
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+    TPG::TPGGraph tpg(env);
+    File::TPGGraphDotImporter dotImporter(argv[1], env, tpg);
+    dotImporter.importGraph();
+
+    int result = 0;
+    if (tpg.getNbRootVertices() == 0) {
+        std::cerr << "No root in " << argv[1] << std::endl;
+        result = 1;
+    } else {
+        PolicyGraph policy = PolicyGraph::extract(*tpg.getRootVertices().front());
+        policy.compact(env);
+
+        std::ofstream output(argv[2]);
+        output << generatePolicyC(policy, env);
+        if (!output.good()) {
+            std::cerr << "Could not write " << argv[2] << std::endl;
+            result = 1;
+        } else {
+            std::cout << "Generated " << argv[2] << ": " << policy.vertices.size() << " vertices, "
+                      << policy.programs.size() << " programs, " << policy.getNbLines() << " lines" << std::endl;
+        }
+    }
+
+    // cleanup
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return result;
+}
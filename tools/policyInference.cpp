@@ -0,0 +1,57 @@
+/**
+* Native inference of a policy compiled by policyCodeGen.
+*
+* Runs episodes of the ArmLearnWrapper towards random goals, with the
+* decisions of the generated policyInference() function instead of a
+* TPG::TPGExecutionEngine, and reports the final state of each episode and
+* the decision latency.
+*
+* Usage: policyInference [nbEpisodes] [nbSteps]
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../src/ArmLearnWrapper.h"
+
+/// Defined by the code generated from POLICY_DOT
+extern "C" uint64_t policyInference(const double *cartesianDif, const double *motorPos);
+
+int main(int argc, char **argv) {
+    uint64_t nbEpisodes = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10;
+    uint64_t nbSteps = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1000;
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    le.setRandomSeed(0);
+
+    double observation[ARM_OBSERVATION_SIZE];
+    double totalLatency = 0.0;
+    double maxLatency = 0.0;
+    // episodes may end before nbSteps
+    uint64_t nbDecisions = 0;
+    for (uint64_t episode = 0; episode < nbEpisodes; episode++) {
+        delete le.targets.front();
+        le.customGoal(le.randomGoal());
+        le.reset();
+
+        for (uint64_t step = 0; step < nbSteps && !le.isTerminal(); step++) {
+            le.copyObservation(observation);
+            auto start = std::chrono::high_resolution_clock::now();
+            uint64_t action = policyInference(observation, observation + 3);
+            auto stop = std::chrono::high_resolution_clock::now();
+            double latency = std::chrono::duration<double, std::micro>(stop - start).count();
+            totalLatency += latency;
+            maxLatency = std::max(maxLatency, latency);
+            nbDecisions++;
+            le.doAction(action);
+        }
+        std::cout << episode << " " << le.toString() << " score " << le.getScore() << std::endl;
+    }
+    delete le.targets.front();
+
+    std::cout << "Decision latency (us): average " << totalLatency / (double) std::max<uint64_t>(nbDecisions, 1) << ", max "
+              << maxLatency << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+* Builds and serves a PolicyLibrary of policies specialized on goal regions.
+*
+* Building takes the first root of each dot file with the box of goals it was
+* trained on. Each policy is validated on random goals of its box, and the
+* mean score of these episodes is stored with its region:
+*   policyLibrary build library.bin policy.dot xmin ymin zmin xmax ymax zmax [policy.dot ...]
+*
+* Running picks the policy of the region nearest to the goal and runs an
+* episode of the ArmLearnWrapper with it:
+*   policyLibrary run library.bin x y z
+*
+* The number of registers and of actions per episode are read from
+* ../../params.json.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/PolicyLibrary.h"
+
+// Number of random goals on which a policy is validated
+#define NB_VALIDATION_GOALS 10
+
+/// Runs an episode of the root towards the goal, returns its score
+static double runEpisode(const TPG::TPGVertex &root, TPG::TPGExecutionEngine &tee, ArmLearnWrapper &le,
+                         const double *goal, uint64_t nbSteps) {
+    delete le.targets.front();
+    le.customGoal(new armlearn::Input<uint16_t>({(uint16_t) std::lround(std::max(goal[0], 0.0)),
+                                                 (uint16_t) std::lround(std::max(goal[1], 0.0)),
+                                                 (uint16_t) std::lround(std::max(goal[2], 0.0))}));
+    le.reset();
+    for (uint64_t step = 0; step < nbSteps && !le.isTerminal(); step++) {
+        le.doAction(((const TPG::TPGAction *) tee.executeFromRoot(root).back())->getActionID());
+    }
+    return le.getScore();
+}
+
+static int build(int argc, char **argv, ArmLearnWrapper &le, Environment &env, uint64_t nbSteps) {
+    if (argc < 10 || (argc - 3) % 7 != 0) {
+        std::cerr << "Usage: " << argv[0] << " build library.bin policy.dot xmin ymin zmin xmax ymax zmax [...]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<TPG::TPGGraph>> graphs;
+    std::vector<const TPG::TPGVertex *> roots;
+    std::vector<PolicyLibrary::Entry> entries;
+    TPG::TPGExecutionEngine tee(env);
+    Mutator::RNG rng(0);
+    for (int arg = 3; arg < argc; arg += 7) {
+        graphs.emplace_back(new TPG::TPGGraph(env));
+        File::TPGGraphDotImporter dotImporter(argv[arg], env, *graphs.back());
+        dotImporter.importGraph();
+        if (graphs.back()->getNbRootVertices() == 0) {
+            std::cerr << "No root in " << argv[arg] << std::endl;
+            return 1;
+        }
+        roots.push_back(graphs.back()->getRootVertices().front());
+
+        PolicyLibrary::Entry entry;
+        for (int i = 0; i < 3; i++) {
+            entry.region.min[i] = std::atof(argv[arg + 1 + i]);
+            entry.region.max[i] = std::atof(argv[arg + 4 + i]);
+        }
+        for (int goalIdx = 0; goalIdx < NB_VALIDATION_GOALS; goalIdx++) {
+            double goal[3];
+            for (int i = 0; i < 3; i++) {
+                goal[i] = rng.getDouble(entry.region.min[i], entry.region.max[i]);
+            }
+            entry.score += runEpisode(*roots.back(), tee, le, goal, nbSteps) / NB_VALIDATION_GOALS;
+        }
+        std::cout << argv[arg] << ": score " << entry.score << std::endl;
+        entries.push_back(entry);
+    }
+
+    PolicyLibrary library(roots, entries, env);
+    library.save(argv[2]);
+    std::cout << "Saved " << library.getNbPolicies() << " policies, " << library.getPolicies().vertices.size()
+              << " vertices, " << library.getPolicies().getNbLines() << " lines" << std::endl;
+    return 0;
+}
+
+static int run(int argc, char **argv, ArmLearnWrapper &le, Environment &env, uint64_t nbSteps) {
+    if (argc < 6) {
+        std::cerr << "Usage: " << argv[0] << " run library.bin x y z" << std::endl;
+        return 1;
+    }
+    PolicyLibrary library = PolicyLibrary::load(argv[2]);
+    double goal[3] = {std::atof(argv[3]), std::atof(argv[4]), std::atof(argv[5])};
+
+    auto start = std::chrono::steady_clock::now();
+    size_t policyIdx = library.findPolicy(goal);
+    auto stop = std::chrono::steady_clock::now();
+    const GoalRegion &region = library.getEntry(policyIdx).region;
+    std::cout << "Policy " << policyIdx << " of region (" << region.min[0] << " ; " << region.min[1] << " ; "
+              << region.min[2] << ") - (" << region.max[0] << " ; " << region.max[1] << " ; " << region.max[2]
+              << "), found in " << std::chrono::duration<double, std::micro>(stop - start).count() << " us"
+              << std::endl;
+
+    TPG::TPGGraph tpg(env);
+    auto roots = library.getPolicies().insertRootsInto(tpg);
+    TPG::TPGExecutionEngine tee(env);
+    double score = runEpisode(*roots[policyIdx], tee, le, goal, nbSteps);
+    std::cout << le.toString() << " score " << score << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " build|run library.bin ..." << std::endl;
+        return 1;
+    }
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson("../../params.json", params);
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+
+    int result = 1;
+    try {
+        std::string command = argv[1];
+        if (command == "build") {
+            result = build(argc, argv, le, env, params.maxNbActionsPerEval);
+        } else if (command == "run") {
+            result = run(argc, argv, le, env, params.maxNbActionsPerEval);
+        } else {
+            std::cerr << "Unknown command " << command << std::endl;
+        }
+    } catch (const std::runtime_error &error) {
+        std::cerr << error.what() << std::endl;
+    }
+
+    delete le.targets.front();
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return result;
+}
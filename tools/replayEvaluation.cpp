@@ -0,0 +1,71 @@
+/**
+* Offline evaluation of trained graphs on recorded trajectories, see ReplayEvaluator.
+*
+* Each root of each dot file is scored on the steps of a trajectory file,
+* without running the arm simulator, so that many checkpoints can be
+* compared before simulating the most promising ones.
+*
+* Usage: replayEvaluation trajectories.bin graph.dot [graph.dot ...]
+* The number of registers is read from ../../params.json, and the
+* rollout length is the one of the longest recorded episode.
+*/
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <gegelati.h>
+
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ReplayEvaluation.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " trajectories.bin graph.dot [graph.dot ...]" << std::endl;
+        return 1;
+    }
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson("../../params.json", params);
+
+    int result = 0;
+    try {
+        ReplayEvaluator evaluator(argv[1], set, params.nbRegisters, std::thread::hardware_concurrency());
+        std::cerr << evaluator.getNbEpisodes() << " episodes, " << evaluator.getNbTransitions() << " transitions"
+                  << std::endl;
+
+        std::cout << "File\tRoot\tAgreement\tRollout\tCoverage" << std::endl;
+        for (int fileIdx = 2; fileIdx < argc; fileIdx++) {
+            TPG::TPGGraph tpg(evaluator.getEnvironment());
+            File::TPGGraphDotImporter dotImporter(argv[fileIdx], evaluator.getEnvironment(), tpg);
+            if (!dotImporter.importGraph()) {
+                std::cerr << "Could not import " << argv[fileIdx] << std::endl;
+                result = 1;
+                continue;
+            }
+
+            auto roots = tpg.getRootVertices();
+            auto scores = evaluator.evaluate(roots);
+            for (size_t rootIdx = 0; rootIdx < roots.size(); rootIdx++) {
+                std::cout << argv[fileIdx] << "\t" << rootIdx << "\t" << scores[rootIdx].agreement << "\t"
+                          << scores[rootIdx].rolloutScore << "\t" << scores[rootIdx].coverage << std::endl;
+            }
+        }
+    } catch (const std::runtime_error &error) {
+        std::cerr << error.what() << std::endl;
+        result = 1;
+    }
+
+    // cleanup
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return result;
+}
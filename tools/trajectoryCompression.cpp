@@ -0,0 +1,134 @@
+/**
+* Executes a trained policy on the arm with a few multi-joint waypoints.
+*
+* The first root of the dot graph is run in simulation towards the goal, and
+* the servo positions it visits are compressed by compressTrajectory(). The
+* waypoints are then executed with an armlearn::Trajectory, as in
+* mainGrabStandalone.cpp, on the SerialController of the given port.
+*
+* Without port, the arm is an ArbotixEmulator, on which the positions of the
+* policy are also executed one by one for comparison: the time and the serial
+* traffic of both executions are reported.
+*
+* Usage: trajectoryCompression policy.dot x y z [tolerance] [nbSteps] [port]
+* The tolerance is in servo units, the number of registers is read from
+* ../../params.json.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <gegelati.h>
+
+#include "../src/ArbotixEmulator.h"
+#include "../src/ArmInstructions.h"
+#include "../src/ArmLearnParameters.h"
+#include "../src/ArmLearnWrapper.h"
+#include "../src/TrajectoryCompression.h"
+
+/// Builds and connects the controller of the WidowX, as mainGrabStandalone.cpp
+static void connectArm(armlearn::communication::AbstractController &arbotix) {
+    armlearn::WidowXBuilder builder;
+    builder.buildController(arbotix);
+    arbotix.connect();
+    arbotix.changeSpeed(50); // Servomotor speed is reduced for safety
+    arbotix.updateInfos();
+}
+
+/// Executes the waypoints with a Trajectory, returns the duration in seconds
+static double executeWaypoints(armlearn::communication::AbstractController &arbotix,
+                               const std::vector<std::vector<uint16_t>> &waypoints) {
+    armlearn::Trajectory path(&arbotix);
+    for (const auto &waypoint : waypoints) {
+        path.addPoint(waypoint);
+    }
+    path.init();
+    auto start = std::chrono::steady_clock::now();
+    path.executeTrajectory();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " policy.dot x y z [tolerance] [nbSteps] [port]" << std::endl;
+        return 1;
+    }
+    double tolerance = (argc > 5) ? std::atof(argv[5]) : 10.0;
+    uint64_t nbSteps = (argc > 6) ? std::strtoull(argv[6], nullptr, 10) : 1000;
+
+    // The instruction set depends on the wrapper parameters the graphs were trained with
+    ArmLearnParameters armParams;
+    loadArmLearnParametersFromJson("../../params.json", armParams);
+    Instructions::Set set;
+    fillArmInstructionSet(set, armParams.ternaryInstructions);
+
+    Learn::LearningParameters params;
+    File::ParametersParser::loadParametersFromJson("../../params.json", params);
+
+    int gen = 0;
+    ArmLearnWrapper le(&gen);
+    Environment env(set, le.getDataSources(), params.nbRegisters);
+    TPG::TPGGraph tpg(env);
+    File::TPGGraphDotImporter dotImporter(argv[1], env, tpg);
+    dotImporter.importGraph();
+    if (tpg.getNbRootVertices() == 0) {
+        std::cerr << "No root in " << argv[1] << std::endl;
+        return 1;
+    }
+    TPG::TPGExecutionEngine tee(env);
+
+    auto goal = armlearn::Input<uint16_t>({(uint16_t) std::atoi(argv[2]), (uint16_t) std::atoi(argv[3]),
+                                          (uint16_t) std::atoi(argv[4])});
+    le.customGoal(&goal);
+    le.reset();
+
+    auto positions = recordPolicyPositions(*tpg.getRootVertices().front(), tee, le, nbSteps);
+    auto waypoints = compressTrajectory(positions, tolerance);
+    std::cout << "Policy: " << le.toString() << std::endl;
+    std::cout << positions.size() << " positions compressed into " << waypoints.size() << " waypoints" << std::endl;
+    for (const auto &waypoint : waypoints) {
+        for (uint16_t value : waypoint) {
+            std::cout << value << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    if (argc > 7) {
+        armlearn::communication::SerialController arbotix(argv[7]);
+        connectArm(arbotix);
+        std::cout << "Executed in " << executeWaypoints(arbotix, waypoints) << " s" << std::endl;
+    } else {
+        ArbotixEmulator emulator;
+        emulator.start();
+        armlearn::communication::SerialController arbotix(emulator.getPortName(), 115200,
+                                                          armlearn::communication::none);
+        connectArm(arbotix);
+
+        // Same start for both executions
+        arbotix.setPosition(positions.front());
+        arbotix.waitFeedback();
+        uint64_t nbCommands = emulator.getNbCommands();
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &position : positions) {
+            arbotix.setPosition(position);
+            arbotix.waitFeedback();
+        }
+        double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Step by step: " << duration << " s, " << emulator.getNbCommands() - nbCommands << " commands"
+                  << std::endl;
+
+        arbotix.setPosition(positions.front());
+        arbotix.waitFeedback();
+        nbCommands = emulator.getNbCommands();
+        duration = executeWaypoints(arbotix, waypoints);
+        std::cout << "Waypoints: " << duration << " s, " << emulator.getNbCommands() - nbCommands << " commands"
+                  << std::endl;
+        emulator.stop();
+    }
+
+    for (unsigned int i = 0; i < set.getNbInstructions(); i++) {
+        delete (&set.getInstruction(i));
+    }
+
+    return 0;
+}
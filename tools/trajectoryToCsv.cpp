@@ -0,0 +1,58 @@
+/**
+* Converts a trajectory file written by a TrajectoryRecorder to CSV.
+*
+* Each line is a step: the state in which the action was taken, the action
+* and the reward obtained after it. Records are streamed from the mapped file
+* from the oldest to the newest one.
+*
+* Usage: trajectoryToCsv trajectories.bin [output.csv]
+* The CSV is written on the standard output when no output file is given.
+*/
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#include "../src/TrajectoryRecorder.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trajectories.bin [output.csv]" << std::endl;
+        return 1;
+    }
+
+    try {
+        TrajectoryReader reader(argv[1]);
+
+        FILE *out = (argc > 2) ? fopen(argv[2], "w") : stdout;
+        if (out == nullptr) {
+            std::cerr << "Could not open " << argv[2] << std::endl;
+            return 1;
+        }
+
+        fprintf(out, "episode,step,action,motor0,motor1,motor2,motor3,motor4,motor5,x,y,z,goalX,goalY,goalZ,reward\n");
+        for (uint64_t i = 0; i < reader.getNbRecords(); i++) {
+            const TrajectoryRecord &record = reader.getRecord(i);
+            fprintf(out, "%llu,%llu,%llu", (unsigned long long) record.episode, (unsigned long long) record.step,
+                    (unsigned long long) record.action);
+            for (double value : record.motorPos) {
+                fprintf(out, ",%g", value);
+            }
+            for (double value : record.cartesianPos) {
+                fprintf(out, ",%.17g", value);
+            }
+            for (double value : record.goal) {
+                fprintf(out, ",%g", value);
+            }
+            fprintf(out, ",%.17g\n", record.reward);
+        }
+
+        if (out != stdout) {
+            fclose(out);
+        }
+        std::cerr << reader.getNbRecords() << " steps converted." << std::endl;
+    } catch (const std::runtime_error &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}